@@ -0,0 +1,702 @@
+#include <cstdio>
+#include <cstring>
+#include "ssd1306.hpp"
+#include "ssd1306_scene.hpp"
+#include "ssd1306_strip_chart.hpp"
+
+#ifdef SSD1306_HOST_BUILD
+    #include <chrono>
+    #include "ssd1306_simulator.hpp"
+#else
+    #include <hardware/clocks.h>
+    #include <pico/stdio.h>
+    #include <pico/time.h>
+#endif
+
+// Runs every drawing primitive and the transfer path over randomized and worst-case inputs and
+// prints one CSV row (or a JSON array with --json on the host) per case.
+
+using Display = SSD1306::OledDisplay<128, 64, true>;
+
+namespace
+{
+constexpr int32_t CALLS = 500;
+
+// Forwards to the real interface and counts what goes over the bus.
+class CountingInterface : public SSD1306::HardwareInterfaceBase
+{
+  public:
+    explicit CountingInterface(SSD1306::HardwareInterfaceBase& interface) :
+        target(interface)
+    {
+    }
+
+    void initialize() override
+    {
+        target.initialize();
+    }
+
+    void sendCommand(uint8_t command) const override
+    {
+        bytes += 1;
+        target.sendCommand(command);
+    }
+
+    void sendCommands(uint8_t* commands, size_t size) const override
+    {
+        bytes += size;
+        target.sendCommands(commands, size);
+    }
+
+    void sendData(uint8_t data) const override
+    {
+        bytes += 1;
+        target.sendData(data);
+    }
+
+    void sendDataBulk(uint8_t* data, size_t size) const override
+    {
+        bytes += size;
+        target.sendDataBulk(data, size);
+    }
+
+    void beginTransaction() const override
+    {
+        target.beginTransaction();
+    }
+
+    void endTransaction() const override
+    {
+        target.endTransaction();
+    }
+
+    void reset() const override
+    {
+        target.reset();
+    }
+
+    mutable uint64_t bytes = 0;
+
+  private:
+    SSD1306::HardwareInterfaceBase& target;
+};
+
+struct Result
+{
+    const char* primitive;
+    const char* input;
+    int32_t calls;
+    uint64_t elapsedNs;
+    uint64_t pixels;
+    uint64_t busBytes;
+};
+
+uint32_t rngState = 0x12345678;
+
+int32_t nextRandom(int32_t limit)
+{
+    // xorshift32, so host and target see the same input sequence
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return static_cast<int32_t>(rngState % static_cast<uint32_t>(limit));
+}
+
+uint64_t nowNs()
+{
+#ifdef SSD1306_HOST_BUILD
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#else
+    return time_us_64() * 1000;
+#endif
+}
+
+// 0 where the clock is unknown, i.e. on the host; the cycles column is then left out.
+uint64_t cpuHz()
+{
+#ifdef SSD1306_HOST_BUILD
+    return 0;
+#else
+    return clock_get_hz(clk_sys);
+#endif
+}
+
+uint64_t litPixels(const Display& display)
+{
+    uint64_t count = 0;
+    const uint8_t* buffer = display.getBuffer();
+    for(int32_t i = 0; i < display.width() * display.height() / 8; ++i)
+    {
+        count += __builtin_popcount(buffer[i]);
+    }
+    return count;
+}
+
+struct Args
+{
+    int32_t v[6];
+};
+
+Args inputs[CALLS];
+
+// Times CALLS invocations of draw over the prepared inputs, then replays every call on a clean
+// buffer to count the pixels it produces.
+template<typename Draw>
+Result run(Display& display, CountingInterface& bus, const char* primitive, const char* input,
+           Draw draw)
+{
+    display.clear();
+    display.display();
+    bus.bytes = 0;
+
+    uint64_t start = nowNs();
+    for(int32_t i = 0; i < CALLS; ++i)
+    {
+        draw(inputs[i]);
+    }
+    uint64_t elapsed = nowNs() - start;
+    uint64_t busBytes = bus.bytes;
+
+    uint64_t pixels = 0;
+    for(int32_t i = 0; i < CALLS; ++i)
+    {
+        display.clear();
+        draw(inputs[i]);
+        pixels += litPixels(display);
+    }
+    return {primitive, input, CALLS, elapsed, pixels, busBytes};
+}
+
+void randomInputs(int32_t maxX, int32_t maxY, int32_t maxW, int32_t maxH)
+{
+    for(auto& args: inputs)
+    {
+        args = {{nextRandom(maxX), nextRandom(maxY), nextRandom(maxX), nextRandom(maxY),
+                 nextRandom(maxW) + 1, nextRandom(maxH) + 1}};
+    }
+}
+
+void fixedInputs(Args args)
+{
+    for(auto& a: inputs)
+    {
+        a = args;
+    }
+}
+
+void print(const Result& r, bool json, bool last)
+{
+    double nsPerCall = static_cast<double>(r.elapsedNs) / r.calls;
+    double nsPerPixel = r.pixels ? static_cast<double>(r.elapsedNs) / r.pixels : 0.0;
+    double busBytesPerCall = static_cast<double>(r.busBytes) / r.calls;
+    char cycles[24] = "null";
+    if(cpuHz() != 0)
+    {
+        snprintf(cycles, sizeof(cycles), "%.0f", nsPerCall * cpuHz() / 1e9);
+    }
+
+    if(json)
+    {
+        printf("  {\"primitive\": \"%s\", \"input\": \"%s\", \"calls\": %d, "
+               "\"ns_per_call\": %.1f, \"ns_per_pixel\": %.2f, \"cycles_per_call\": %s, "
+               "\"bus_bytes_per_call\": %.1f}%s\n",
+               r.primitive, r.input, static_cast<int>(r.calls), nsPerCall, nsPerPixel, cycles,
+               busBytesPerCall, last ? "" : ",");
+    }
+    else if(cpuHz() != 0)
+    {
+        printf("%s,%s,%d,%.1f,%.2f,%s,%.1f\n", r.primitive, r.input, static_cast<int>(r.calls),
+               nsPerCall, nsPerPixel, cycles, busBytesPerCall);
+    }
+    else
+    {
+        printf("%s,%s,%d,%.1f,%.2f,%.1f\n", r.primitive, r.input, static_cast<int>(r.calls),
+               nsPerCall, nsPerPixel, busBytesPerCall);
+    }
+}
+
+const uint8_t* bitmapData()
+{
+    static uint8_t bitmap[64 * 64 / 8];
+    for(auto& b: bitmap)
+    {
+        b = static_cast<uint8_t>(nextRandom(256));
+    }
+    return bitmap;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+#ifdef SSD1306_HOST_BUILD
+    bool json = argc > 1 && strcmp(argv[1], "--json") == 0;
+    SSD1306::SimulatedSSD1306 panel;
+#else
+    (void)argc;
+    (void)argv;
+    bool json = false;
+    stdio_init_all();
+    SSD1306::SPIInterface panel;
+#endif
+    CountingInterface bus(panel);
+    Display display(bus);
+
+    const uint8_t* bitmap = bitmapData();
+    constexpr int32_t MAX_RESULTS = 64;
+    Result results[MAX_RESULTS];
+    int32_t count = 0;
+
+    randomInputs(128, 64, 1, 1);
+    results[count++] = run(display, bus, "drawPixel", "random",
+                           [&](const Args& a) { display.drawPixel(a.v[0], a.v[1]); });
+
+    results[count++] = run(display, bus, "drawLine", "random", [&](const Args& a) {
+        display.drawLine(a.v[0], a.v[1], a.v[2], a.v[3]);
+    });
+    results[count++] = run(display, bus, "drawLine", "random-xor", [&](const Args& a) {
+        display.drawLine(a.v[0], a.v[1], a.v[2], a.v[3], SSD1306::DrawMode::XOR);
+    });
+    fixedInputs({{0, 0, 127, 63, 0, 0}});
+    results[count++] = run(display, bus, "drawLine", "diagonal", [&](const Args& a) {
+        display.drawLine(a.v[0], a.v[1], a.v[2], a.v[3]);
+    });
+
+    // Long lines that mostly run outside the display: clipping skips straight to the visible
+    // part instead of stepping through every offscreen pixel.
+    randomInputs(2048, 1024, 1, 1);
+    results[count++] = run(display, bus, "drawLine", "mostly-offscreen", [&](const Args& a) {
+        display.drawLine(a.v[0] - 960, a.v[1] - 480, a.v[2] - 960, a.v[3] - 480);
+    });
+
+    randomInputs(128, 64, 128, 1);
+    results[count++] = run(display, bus, "drawFastHLine", "random", [&](const Args& a) {
+        display.drawFastHLine(a.v[0], a.v[1], a.v[4]);
+    });
+
+    randomInputs(128, 64, 64, 32);
+    results[count++] = run(display, bus, "fillRect", "random", [&](const Args& a) {
+        display.fillRect(a.v[0], a.v[1], a.v[4], a.v[5]);
+    });
+    results[count++] = run(display, bus, "fillRect", "random-xor", [&](const Args& a) {
+        display.fillRect(a.v[0], a.v[1], a.v[4], a.v[5], SSD1306::DrawMode::XOR);
+    });
+    // Per-pixel fill as fillRect was implemented before the page-masked span fills.
+    results[count++] = run(display, bus, "fillRect", "random-per-pixel", [&](const Args& a) {
+        for(int32_t x = a.v[0]; x < a.v[0] + a.v[4]; ++x)
+        {
+            for(int32_t y = a.v[1]; y < a.v[1] + a.v[5]; ++y)
+            {
+                display.drawPixel(x, y);
+            }
+        }
+    });
+    fixedInputs({{0, 0, 0, 0, 128, 64}});
+    results[count++] = run(display, bus, "fillRect", "fullscreen", [&](const Args& a) {
+        display.fillRect(a.v[0], a.v[1], a.v[4], a.v[5]);
+    });
+
+    randomInputs(128, 64, 64, 32);
+    results[count++] = run(display, bus, "drawRect", "random", [&](const Args& a) {
+        display.drawRect(a.v[0], a.v[1], a.v[4], a.v[5]);
+    });
+
+    randomInputs(96, 32, 32, 32);
+    results[count++] = run(display, bus, "drawCircle", "random", [&](const Args& a) {
+        display.drawCircle(a.v[0] + 16, a.v[1] + 16, a.v[4] / 2);
+    });
+    // Eight drawPixel calls per step, as drawCircle was implemented before the octant spans.
+    results[count++] = run(display, bus, "drawCircle", "random-per-pixel", [&](const Args& a) {
+        int32_t x0 = a.v[0] + 16;
+        int32_t y0 = a.v[1] + 16;
+        int32_t x = a.v[4] / 2;
+        int32_t y = 0;
+        int32_t err = 0;
+        while(x >= y)
+        {
+            display.drawPixel(x0 + x, y0 + y);
+            display.drawPixel(x0 + y, y0 + x);
+            display.drawPixel(x0 - y, y0 + x);
+            display.drawPixel(x0 - x, y0 + y);
+            display.drawPixel(x0 - x, y0 - y);
+            display.drawPixel(x0 - y, y0 - x);
+            display.drawPixel(x0 + y, y0 - x);
+            display.drawPixel(x0 + x, y0 - y);
+            y++;
+            if(err <= 0)
+            {
+                err += 2 * y + 1;
+            }
+            else
+            {
+                x--;
+                err += 2 * (y - x) + 1;
+            }
+        }
+    });
+    results[count++] = run(display, bus, "fillCircle", "random", [&](const Args& a) {
+        display.fillCircle(a.v[0] + 16, a.v[1] + 16, a.v[4] / 2);
+    });
+    // Pixel at a time over the bounding box.
+    results[count++] = run(display, bus, "fillCircle", "random-per-pixel", [&](const Args& a) {
+        int32_t r = a.v[4] / 2;
+        for(int32_t dy = -r; dy <= r; ++dy)
+        {
+            for(int32_t dx = -r; dx <= r; ++dx)
+            {
+                if(dx * dx + dy * dy <= r * r + r)
+                {
+                    display.drawPixel(a.v[0] + 16 + dx, a.v[1] + 16 + dy);
+                }
+            }
+        }
+    });
+    fixedInputs({{64, 32, 0, 0, 31, 0}});
+    results[count++] = run(display, bus, "drawCircle", "r31", [&](const Args& a) {
+        display.drawCircle(a.v[0], a.v[1], a.v[4]);
+    });
+    results[count++] = run(display, bus, "fillCircle", "r31", [&](const Args& a) {
+        display.fillCircle(a.v[0], a.v[1], a.v[4]);
+    });
+
+    randomInputs(96, 32, 32, 32);
+    results[count++] = run(display, bus, "drawEllipse", "random", [&](const Args& a) {
+        display.drawEllipse(a.v[0] + 16, a.v[1] + 16, a.v[4] / 2, a.v[5] / 2);
+    });
+    results[count++] = run(display, bus, "fillEllipse", "random", [&](const Args& a) {
+        display.fillEllipse(a.v[0] + 16, a.v[1] + 16, a.v[4] / 2, a.v[5] / 2);
+    });
+
+    randomInputs(128, 64, 64, 32);
+    results[count++] = run(display, bus, "drawRoundRect", "random-r4", [&](const Args& a) {
+        display.drawRoundRect(a.v[0], a.v[1], a.v[4], a.v[5], 4);
+    });
+    results[count++] = run(display, bus, "fillRoundRect", "random-r4", [&](const Args& a) {
+        display.fillRoundRect(a.v[0], a.v[1], a.v[4], a.v[5], 4);
+    });
+
+    randomInputs(128, 64, 1, 1);
+    for(auto& a: inputs)
+    {
+        a.v[4] = nextRandom(128);
+        a.v[5] = nextRandom(64);
+    }
+    results[count++] = run(display, bus, "fillTriangle", "random", [&](const Args& a) {
+        display.fillTriangle(a.v[0], a.v[1], a.v[2], a.v[3], a.v[4], a.v[5]);
+    });
+    fixedInputs({{0, 0, 127, 0, 64, 63}});
+    results[count++] = run(display, bus, "fillTriangle", "fullscreen", [&](const Args& a) {
+        display.fillTriangle(a.v[0], a.v[1], a.v[2], a.v[3], a.v[4], a.v[5]);
+    });
+
+    const char text[] = "The quick brown fox";
+    randomInputs(24, 56, 1, 1);
+    results[count++] = run(display, bus, "drawText", "random-19chars",
+                           [&](const Args& a) { display.drawText(a.v[0], a.v[1], text); });
+    fixedInputs({{0, 3, 0, 0, 0, 0}});
+    results[count++] = run(display, bus, "drawText", "unaligned-19chars",
+                           [&](const Args& a) { display.drawText(a.v[0], a.v[1], text); });
+
+    results[count++] = run(display, bus, "drawText", "unaligned-19chars-template",
+                           [&](const Args& a) {
+                               display.drawText<Fonts::Font5x8>(a.v[0], a.v[1], text);
+                           });
+    results[count++] = run(display, bus, "drawText", "unaligned-19chars-copy",
+                           [&](const Args& a) {
+                               display.drawText<Fonts::Font5x8>(a.v[0], a.v[1], text,
+                                                                SSD1306::DrawMode::COPY);
+                           });
+    // Bit by bit through drawPixel, as glyphs were drawn before the column blit.
+    results[count++] = run(display, bus, "drawText", "unaligned-19chars-per-pixel",
+                           [&](const Args& a) {
+                               FontBase* font = Fonts::getFont(Fonts::FontType::FONT5X8);
+                               int32_t x = a.v[0];
+                               for(char c: text)
+                               {
+                                   if(c == '\0')
+                                   {
+                                       break;
+                                   }
+                                   const uint8_t* glyph =
+                                       &font->getFontData()[(c - font->characterOffset()) *
+                                                            font->width()];
+                                   for(int32_t i = 0; i < font->width(); ++i)
+                                   {
+                                       for(int32_t j = 0; j < font->height(); ++j)
+                                       {
+                                           if(glyph[i] & (1 << j))
+                                           {
+                                               display.drawPixel(x + i, a.v[1] + j);
+                                           }
+                                       }
+                                   }
+                                   x += font->width() + font->characterSpace();
+                               }
+                           });
+
+    randomInputs(64, 1, 1, 1);
+    results[count++] = run(display, bus, "drawBitmap", "64x64-aligned", [&](const Args& a) {
+        display.drawBitmap(a.v[0], 0, bitmap, 64, 64);
+    });
+    randomInputs(192, 112, 1, 1);
+    results[count++] = run(display, bus, "drawBitmap", "64x48-partly-offscreen",
+                           [&](const Args& a) {
+                               display.drawBitmap(a.v[0] - 64, a.v[1] - 48, bitmap, 64, 48);
+                           });
+    randomInputs(64, 8, 1, 1);
+    results[count++] = run(display, bus, "drawBitmap", "64x64-unaligned", [&](const Args& a) {
+        display.drawBitmap(a.v[0], a.v[1], bitmap, 64, 56);
+    });
+    results[count++] = run(display, bus, "drawBitmap", "64x64-unaligned-copy", [&](const Args& a) {
+        display.drawBitmap(a.v[0], a.v[1], bitmap, 64, 56, SSD1306::DrawMode::COPY);
+    });
+    results[count++] = run(display, bus, "drawBitmap", "64x64-unaligned-xor", [&](const Args& a) {
+        display.drawBitmap(a.v[0], a.v[1], bitmap, 64, 56, SSD1306::DrawMode::XOR);
+    });
+    // Bit by bit through drawPixel, as drawBitmap was implemented before the column blit.
+    results[count++] = run(display, bus, "drawBitmap", "64x64-unaligned-per-pixel",
+                           [&](const Args& a) {
+                               for(int32_t j = 0; j < 56; ++j)
+                               {
+                                   for(int32_t i = 0; i < 64; ++i)
+                                   {
+                                       if(bitmap[i + (j / 8) * 64] & (1 << (j % 8)))
+                                       {
+                                           display.drawPixel(a.v[0] + i, a.v[1] + j);
+                                       }
+                                   }
+                               }
+                           });
+    results[count++] = run(display, bus, "drawBitmapHorizontal", "64x56", [&](const Args& a) {
+        display.drawBitmapHorizontal(a.v[0], a.v[1], bitmap, 64, 56);
+    });
+    // Bit by bit through drawPixel, as drawBitmapHorizontal was implemented before the tile
+    // transpose.
+    results[count++] = run(display, bus, "drawBitmapHorizontal", "64x56-per-pixel",
+                           [&](const Args& a) {
+                               for(int32_t j = 0; j < 56; ++j)
+                               {
+                                   for(int32_t i = 0; i < 64; ++i)
+                                   {
+                                       if(bitmap[j * 8 + i / 8] & (0x80 >> (i % 8)))
+                                       {
+                                           display.drawPixel(a.v[0] + i, a.v[1] + j);
+                                       }
+                                   }
+                               }
+                           });
+    static uint8_t converted[SSD1306::pageBitmapSize(64, 56)];
+    results[count++] = run(display, bus, "convertBitmap", "64x56", [&](const Args&) {
+        SSD1306::convertBitmap(bitmap, 64, 56, converted);
+    });
+
+    fixedInputs({{0, 0, 0, 0, 0, 0}});
+    results[count++] = run(display, bus, "display", "full-frame", [&](const Args&) {
+        display.clear();
+        display.display();
+    });
+    results[count++] = run(display, bus, "display", "one-digit", [&](const Args&) {
+        display.clearRect(56, 42, 6, 8);
+        display.drawChar(56, 42, '0' + nextRandom(10));
+        display.display();
+    });
+    randomInputs(128, 64, 1, 1);
+    results[count++] = run(display, bus, "display", "two-scattered-pixels", [&](const Args& a) {
+        display.drawPixel(a.v[0], a.v[1]);
+        display.drawPixel(a.v[2], a.v[3]);
+        display.display();
+    });
+    results[count++] = run(display, bus, "displayFull", "full-frame",
+                           [&](const Args&) { display.displayFull(); });
+
+    // A log console adding one line of text at the bottom and scrolling the rest up, by redrawing
+    // every line or by moving the start line and drawing only the new one.
+    char line[] = "line 0";
+    results[count++] = run(display, bus, "console", "redraw", [&](const Args&) {
+        display.clear();
+        for(int32_t i = 0; i < 8; ++i)
+        {
+            line[5] = '0' + nextRandom(10);
+            display.drawText(0, i * 8, line);
+        }
+        display.display();
+    });
+    results[count++] = run(display, bus, "console", "start-line-scroll", [&](const Args&) {
+        display.setStartLine(display.getStartLine() + 8);
+        int32_t row = display.bufferRow(display.height() - 8);
+        line[5] = '0' + nextRandom(10);
+        display.clearRect(0, row, display.width(), 8);
+        display.drawText(0, row, line);
+        display.display();
+    });
+    display.setStartLine(0);
+
+    randomInputs(128, 64, 64, 32);
+    results[count++] = run(display, bus, "copyRect", "random", [&](const Args& a) {
+        display.copyRect(a.v[0], a.v[1], a.v[4], a.v[5], a.v[2], a.v[3]);
+    });
+    fixedInputs({{0, 0, 0, 0, 0, 0}});
+    results[count++] = run(display, bus, "scroll", "1px-left",
+                           [&](const Args&) { display.scroll(-1, 0); });
+    results[count++] = run(display, bus, "scroll", "3px-up",
+                           [&](const Args&) { display.scroll(0, -3); });
+
+    // A strip chart of the last 128 samples gaining one sample per frame, by replotting every
+    // segment or by shifting the plot one column left and drawing only the newest segment.
+    static int32_t samples[128];
+    for(auto& sample: samples)
+    {
+        sample = nextRandom(48);
+    }
+    int32_t newest = 0;
+    results[count++] = run(display, bus, "chart", "replot", [&](const Args&) {
+        newest = (newest + 1) % 128;
+        samples[newest] = nextRandom(48);
+        display.clearRect(0, 16, 128, 48);
+        for(int32_t x = 1; x < 128; ++x)
+        {
+            display.drawLine(x - 1, 63 - samples[(newest + x) % 128], x,
+                             63 - samples[(newest + x + 1) % 128]);
+        }
+        display.display();
+    });
+    results[count++] = run(display, bus, "chart", "shift", [&](const Args&) {
+        int32_t previous = samples[newest];
+        newest = (newest + 1) % 128;
+        samples[newest] = nextRandom(48);
+        display.copyRect(1, 16, 127, 48, 0, 16);
+        display.clearRect(127, 16, 1, 48);
+        display.drawLine(126, 63 - previous, 127, 63 - samples[newest]);
+        display.display();
+    });
+
+    // The same chart through StripChart: one sample per frame with a fixed range and with
+    // autoscaling, and four samples folded into each column.
+    using Chart = SSD1306::StripChart<Display>;
+    static Chart fixedChart(display, 0, 16, 128, 48);
+    fixedChart.setRange(0, 47);
+    results[count++] = run(display, bus, "stripChart", "fixed-range", [&](const Args&) {
+        fixedChart.push(nextRandom(48));
+        fixedChart.render();
+        display.display();
+    });
+    static Chart autoChart(display, 0, 16, 128, 48);
+    results[count++] = run(display, bus, "stripChart", "autoscale", [&](const Args&) {
+        autoChart.push(nextRandom(48));
+        autoChart.render();
+        display.display();
+    });
+    static Chart decimatedChart(display, 0, 16, 128, 48);
+    decimatedChart.setRange(0, 47);
+    decimatedChart.setSamplesPerColumn(4);
+    results[count++] = run(display, bus, "stripChart", "4-samples-per-column", [&](const Args&) {
+        for(int32_t i = 0; i < 4; ++i)
+        {
+            decimatedChart.push(nextRandom(48));
+        }
+        decimatedChart.render();
+        display.display();
+    });
+
+    // A mostly static screen with one live value, redrawn from scratch and kept as a scene.
+    auto drawDashboard = [](auto& target, const char (&value)[4]) {
+        target.drawRect(0, 0, 128, 64);
+        target.drawText(4, 4, "Pressure");
+        target.drawText(4, 16, "Flow");
+        target.drawText(4, 28, "Temp");
+        target.drawFastHLine(0, 40, 128);
+        target.drawCircle(100, 20, 14);
+        target.drawText(70, 16, "1.2");
+        target.drawText(70, 28, "21.5");
+        target.drawText(70, 4, value);
+    };
+    char value[4] = "000";
+    results[count++] = run(display, bus, "dashboard", "full-redraw", [&](const Args&) {
+        value[2] = '0' + nextRandom(10);
+        display.clear();
+        drawDashboard(display, value);
+        display.display();
+    });
+    using Scene = SSD1306::Scene<Display>;
+    static Scene scene(display);
+    scene.addRect(0, 0, 128, 64);
+    scene.addText(4, 4, "Pressure");
+    scene.addText(4, 16, "Flow");
+    scene.addText(4, 28, "Temp");
+    scene.addLine(0, 40, 127, 40);
+    scene.addCircle(100, 20, 14);
+    scene.addText(70, 16, "1.2");
+    scene.addText(70, 28, "21.5");
+    Scene::Handle live = scene.addText(70, 4, value);
+    results[count++] = run(display, bus, "dashboard", "scene-one-value", [&](const Args&) {
+        value[2] = '0' + nextRandom(10);
+        scene.setText(live, value);
+        scene.render();
+        display.display();
+    });
+
+    // A needle moving over a dial, redrawn from scratch or erased with XOR and drawn again in
+    // its new place, which restores whatever it crossed.
+    auto drawDial = [&]() {
+        display.drawCircle(64, 63, 60);
+        display.drawText(4, 0, "0");
+        display.drawText(118, 0, "100");
+    };
+    int32_t needleX = 64;
+    int32_t needleY = 8;
+    results[count++] = run(display, bus, "gauge", "full-redraw", [&](const Args&) {
+        display.clear();
+        drawDial();
+        display.drawLine(64, 63, 4 + nextRandom(120), 8 + nextRandom(32));
+        display.display();
+    });
+    display.clear();
+    drawDial();
+    display.drawLine(64, 63, needleX, needleY, SSD1306::DrawMode::XOR);
+    results[count++] = run(display, bus, "gauge", "xor-move", [&](const Args&) {
+        display.drawLine(64, 63, needleX, needleY, SSD1306::DrawMode::XOR);
+        needleX = 4 + nextRandom(120);
+        needleY = 8 + nextRandom(32);
+        display.drawLine(64, 63, needleX, needleY, SSD1306::DrawMode::XOR);
+        display.display();
+    });
+
+    // The dashboard drawn and sent whole through renderStrips(), once into the full frame buffer
+    // and once a page at a time through a 128-byte strip buffer. Goes last, as the strip display
+    // takes over the panel.
+    results[count++] = run(display, bus, "dashboard", "render-full-buffer", [&](const Args&) {
+        value[2] = '0' + nextRandom(10);
+        display.renderStrips([&](Display& target) { drawDashboard(target, value); });
+    });
+    SSD1306::StripDisplay<128, 64, 1, true> stripDisplay(bus);
+    results[count++] = run(display, bus, "dashboard", "render-1-page-strips", [&](const Args&) {
+        value[2] = '0' + nextRandom(10);
+        stripDisplay.renderStrips([&](auto& target) { drawDashboard(target, value); });
+    });
+
+    if(json)
+    {
+        printf("[\n");
+    }
+    else
+    {
+        printf("primitive,input,calls,ns_per_call,ns_per_pixel,%sbus_bytes_per_call\n",
+               cpuHz() != 0 ? "cycles_per_call," : "");
+    }
+    for(int32_t i = 0; i < count; ++i)
+    {
+        print(results[i], json, i + 1 == count);
+    }
+    if(json)
+    {
+        printf("]\n");
+    }
+
+#ifndef SSD1306_HOST_BUILD
+    while(true)
+    {
+        sleep_ms(1000);
+    }
+#endif
+}
@@ -0,0 +1,175 @@
+#include <cmath>
+#include <cstdio>
+#include "ssd1306.hpp"
+#include "ssd1306_pipeline.hpp"
+
+#ifdef SSD1306_HOST_BUILD
+    #include <atomic>
+    #include <chrono>
+    #include <thread>
+    #include "ssd1306_simulator.hpp"
+#else
+    #include <pico/multicore.h>
+    #include <pico/stdio.h>
+    #include <pico/time.h>
+#endif
+
+// Animated gauge rendered on one core and sent to the panel from the other. On the host a thread
+// stands in for core 1, drawing is padded to 600 us and the simulated panel is slowed down to a
+// 10 MHz SPI bus. The example compares drawing and sending on one core with the pipeline under
+// each frame policy.
+
+using Display = SSD1306::OledDisplay<128, 64, true>;
+
+namespace
+{
+constexpr int32_t FRAMES = 300;
+
+uint64_t nowUs()
+{
+#ifdef SSD1306_HOST_BUILD
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#else
+    return time_us_64();
+#endif
+}
+
+void drawGauge(Display& display, int32_t frame)
+{
+    constexpr int32_t CX = 64;
+    constexpr int32_t CY = 60;
+    constexpr int32_t R = 50;
+
+    display.clear();
+    display.drawCircle(CX, CY, R);
+    for(int32_t tick = 0; tick <= 10; ++tick)
+    {
+        float angle = 3.14159f * tick / 10;
+        display.drawLine(CX - static_cast<int32_t>((R - 6) * cosf(angle)),
+                         CY - static_cast<int32_t>((R - 6) * sinf(angle)),
+                         CX - static_cast<int32_t>(R * cosf(angle)),
+                         CY - static_cast<int32_t>(R * sinf(angle)));
+    }
+
+    float value = 0.5f + 0.5f * sinf(frame * 0.05f);
+    float angle = 3.14159f * value;
+    display.drawLine(CX, CY, CX - static_cast<int32_t>((R - 10) * cosf(angle)),
+                     CY - static_cast<int32_t>((R - 10) * sinf(angle)));
+
+    char text[8];
+    snprintf(text, sizeof(text), "%3d%%", static_cast<int>(value * 100));
+    display.drawText<Fonts::Font5x8>(52, 40, text);
+
+#ifdef SSD1306_HOST_BUILD
+    // Stands in for the time a real scene takes to draw on the RP2040.
+    std::this_thread::sleep_for(std::chrono::microseconds(600));
+#endif
+}
+
+void report(const char* name, uint64_t elapsedUs, uint32_t submitted, uint32_t dropped,
+            uint32_t sent)
+{
+    printf("%s,%.0f,%.0f,%lu,%lu\n", name, submitted * 1e6 / elapsedUs, sent * 1e6 / elapsedUs,
+           static_cast<unsigned long>(dropped), static_cast<unsigned long>(submitted - sent));
+}
+
+#ifdef SSD1306_HOST_BUILD
+// Holds every data transfer for as long as a 10 MHz SPI bus would need for it.
+class SlowBus : public SSD1306::SimulatedSSD1306
+{
+  public:
+    void sendDataBulk(uint8_t* data, size_t size) const override
+    {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(size * 800));
+        SimulatedSSD1306::sendDataBulk(data, size);
+    }
+};
+
+template<SSD1306::FramePolicy POLICY>
+void runPipeline(const char* name, Display& display)
+{
+    SSD1306::FramePipeline<Display, POLICY> pipeline(display);
+    std::atomic<bool> stop{false};
+
+    std::thread core1([&] {
+        while(!stop.load())
+        {
+            pipeline.transferNext();
+        }
+        while(pipeline.transferNext())
+        {
+        }
+    });
+
+    uint64_t start = nowUs();
+    for(int32_t frame = 0; frame < FRAMES; ++frame)
+    {
+        drawGauge(display, frame);
+        pipeline.submit();
+    }
+    stop.store(true);
+    core1.join();
+
+    const auto& frames = pipeline.frames();
+    report(name, nowUs() - start, frames.framesSubmitted(), frames.framesDropped(),
+           frames.framesSent());
+}
+#else
+SSD1306::FramePipeline<Display>* pipeline = nullptr;
+
+void core1Entry()
+{
+    while(true)
+    {
+        pipeline->transferNext();
+    }
+}
+#endif
+} // namespace
+
+int main()
+{
+    printf("setup,rendered_fps,sent_fps,dropped,superseded\n");
+
+#ifdef SSD1306_HOST_BUILD
+    SlowBus panel;
+    Display display(panel);
+
+    uint64_t start = nowUs();
+    for(int32_t frame = 0; frame < FRAMES; ++frame)
+    {
+        drawGauge(display, frame);
+        display.display();
+    }
+    report("single-core", nowUs() - start, FRAMES, 0, FRAMES);
+
+    runPipeline<SSD1306::FramePolicy::WAIT>("wait", display);
+    runPipeline<SSD1306::FramePolicy::DROP_NEWEST>("drop-newest", display);
+    runPipeline<SSD1306::FramePolicy::LATEST_WINS>("latest-wins", display);
+#else
+    stdio_init_all();
+    Display display;
+
+    static SSD1306::FramePipeline<Display> gaugePipeline(display);
+    pipeline = &gaugePipeline;
+    multicore_launch_core1(core1Entry);
+
+    for(int32_t frame = 0;;)
+    {
+        uint64_t start = nowUs();
+        uint32_t submitted = pipeline->frames().framesSubmitted();
+        uint32_t sent = pipeline->frames().framesSent();
+        for(int32_t i = 0; i < FRAMES; ++i, ++frame)
+        {
+            drawGauge(display, frame);
+            pipeline->submit();
+        }
+        report("latest-wins", nowUs() - start, pipeline->frames().framesSubmitted() - submitted,
+               0, pipeline->frames().framesSent() - sent);
+    }
+#endif
+
+    return 0;
+}
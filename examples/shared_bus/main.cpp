@@ -0,0 +1,127 @@
+#include <cstdio>
+#include <cstring>
+#include "ssd1306.hpp"
+#include "ssd1306_shared_bus.hpp"
+
+#ifdef SSD1306_HOST_BUILD
+    #include <chrono>
+    #include "ssd1306_simulator.hpp"
+#else
+    #include <pico/stdio.h>
+    #include <pico/time.h>
+#endif
+
+// Two panels on one SPI bus: the left one redraws its whole frame every time, the right one only
+// updates a counter. For each scheduling setup the example prints how many bus bytes went out
+// before the right panel's small update had been delivered, and the aggregate throughput.
+
+using Display = SSD1306::OledDisplay<128, 64, true>;
+using Bus = SSD1306::SharedBus<2>;
+
+namespace
+{
+constexpr int32_t FRAMES = 200;
+constexpr int32_t LEFT = 0;
+constexpr int32_t RIGHT = 1;
+
+uint64_t nowUs()
+{
+#ifdef SSD1306_HOST_BUILD
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#else
+    return time_us_64();
+#endif
+}
+
+void runSetup(const char* name, Bus& bus, Display& left, Display& right)
+{
+    bus.flush();
+    bus.resetStatistics();
+
+    uint64_t bytesAhead = 0;
+    uint64_t start = nowUs();
+    for(int32_t frame = 0; frame < FRAMES; ++frame)
+    {
+        left.clear();
+        for(int32_t x = frame % 8; x < left.width(); x += 8)
+        {
+            left.drawFastVLine(x, 0, left.height());
+        }
+        left.display();
+
+        char text[12];
+        snprintf(text, sizeof(text), "%ld", static_cast<long>(frame));
+        right.clearRect(0, 0, 48, 8);
+        right.drawText<Fonts::Font5x8>(0, 0, text);
+        right.display();
+
+        // Bytes the bus moves for the other panel until the counter has reached its panel. The
+        // service() call that retires the last slice may already start the next one, which is
+        // not counted.
+        uint64_t before = bus.statistics(LEFT).bytes;
+        uint64_t ahead = before;
+        while(bus.port(RIGHT).isBusy())
+        {
+            ahead = bus.statistics(LEFT).bytes;
+            bus.service();
+        }
+        bytesAhead += ahead - before;
+        bus.flush();
+    }
+    uint64_t elapsed = nowUs() - start;
+
+    uint64_t total = bus.statistics(LEFT).bytes + bus.statistics(RIGHT).bytes;
+    printf("%s,%.1f,%lu,%lu,%.0f\n", name, static_cast<double>(bytesAhead) / FRAMES,
+           static_cast<unsigned long>(bus.statistics(LEFT).bytes / FRAMES),
+           static_cast<unsigned long>(bus.statistics(RIGHT).bytes / FRAMES),
+           elapsed ? total * 1e6 / elapsed : 0.0);
+}
+} // namespace
+
+int main()
+{
+#ifdef SSD1306_HOST_BUILD
+    SSD1306::SimulatedSSD1306 leftPanel;
+    SSD1306::SimulatedSSD1306 rightPanel;
+#else
+    stdio_init_all();
+
+    // Both panels on the default SPI block; the right one has its own CS, DC and RST pins.
+    SSD1306::SPIInterface leftPanel;
+    SSD1306::SPIConfig rightConfig;
+    rightConfig.csPin = 22;
+    rightConfig.dcPin = 26;
+    rightConfig.rstPin = 27;
+    SSD1306::SPIInterface rightPanel(rightConfig);
+#endif
+
+    Bus bus;
+    Display left(bus.attach(LEFT, leftPanel));
+    Display right(bus.attach(RIGHT, rightPanel));
+
+    do
+    {
+        printf("setup,bytes_ahead_of_small_update,left_bytes_per_frame,right_bytes_per_frame,"
+               "bytes_per_second\n");
+
+        // One slice per frame: the panels are served in arrival order.
+        bus.setSliceSize(1024);
+        runSetup("fifo", bus, left, right);
+
+        bus.setSliceSize(128);
+        runSetup("round-robin", bus, left, right);
+
+        bus.setPriority(RIGHT, 1);
+        runSetup("priority", bus, left, right);
+        bus.setPriority(RIGHT, 0);
+    }
+#ifdef SSD1306_HOST_BUILD
+    while(false);
+#else
+    while(true);
+#endif
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <stddef.h>
+
+namespace SSD1306
+{
+// Conversion of row-major, MSB-first bitmaps (the PBM/XBM layout used by drawBitmapHorizontal)
+// into the SSD1306 page layout used by drawBitmap: one byte per column, LSB at the top.
+
+// Size in bytes of a width x height bitmap in page layout.
+constexpr size_t pageBitmapSize(int32_t width, int32_t height)
+{
+    return static_cast<size_t>(width) * ((height + 7) / 8);
+}
+
+// Transposes an 8x8 tile: rows[i * stride] holds source row i (MSB is the leftmost pixel), the
+// result holds the 8 column bytes of the tile with row 0 in the LSB. Rows from rowCount on read
+// as empty. Bit butterfly on two 32-bit words (Hacker's Delight, transpose8), with the rows
+// loaded bottom up so the top row ends in the LSB.
+inline void transposeTile(const uint8_t* rows, size_t stride, int32_t rowCount, uint8_t* columns)
+{
+    uint8_t r[8] = {};
+    for(int32_t i = 0; i < rowCount && i < 8; ++i)
+    {
+        r[i] = rows[i * stride];
+    }
+
+    uint32_t x = (static_cast<uint32_t>(r[7]) << 24) | (r[6] << 16) | (r[5] << 8) | r[4];
+    uint32_t y = (static_cast<uint32_t>(r[3]) << 24) | (r[2] << 16) | (r[1] << 8) | r[0];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    columns[0] = x >> 24;
+    columns[1] = x >> 16;
+    columns[2] = x >> 8;
+    columns[3] = x;
+    columns[4] = y >> 24;
+    columns[5] = y >> 16;
+    columns[6] = y >> 8;
+    columns[7] = y;
+}
+
+// Converts a whole row-major bitmap once, e.g. an asset loaded at runtime, so it can be drawn
+// repeatedly with drawBitmap. pageMajor must hold pageBitmapSize(width, height) bytes.
+inline void convertBitmap(const uint8_t* rowMajor, int32_t width, int32_t height,
+                          uint8_t* pageMajor)
+{
+    size_t bytesPerRow = (width + 7) / 8;
+    for(int32_t row = 0; row * 8 < height; ++row)
+    {
+        const uint8_t* source = &rowMajor[row * 8 * bytesPerRow];
+        uint8_t* destination = &pageMajor[row * width];
+        int32_t rowCount = height - row * 8;
+
+        for(int32_t column = 0; column < width; column += 8)
+        {
+            uint8_t tile[8];
+            transposeTile(&source[column / 8], bytesPerRow, rowCount, tile);
+
+            int32_t count = width - column < 8 ? width - column : 8;
+            for(int32_t i = 0; i < count; ++i)
+            {
+                destination[column + i] = tile[i];
+            }
+        }
+    }
+}
+} // namespace SSD1306
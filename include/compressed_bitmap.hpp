@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <stddef.h>
+
+namespace SSD1306
+{
+// Run-length encoded bitmap in the SSD1306 page layout, as produced by
+// tools/bitmap_converter.py. The decoded stream is the same as the drawBitmap() input: one byte
+// per column, LSB at the top, page rows of `width` bytes one after the other.
+//
+// The stream is a sequence of packets, each starting with a control byte whose two top bits
+// select the packet type and whose low six bits hold the run length minus one (1..64 bytes):
+//   00nnnnnn  literal, n + 1 bytes follow
+//   01nnnnnn  the following byte repeated n + 1 times
+//   10nnnnnn  n + 1 bytes of 0x00
+//   11nnnnnn  n + 1 bytes of 0xFF
+// Packets may continue across page rows. Decoding stops at a packet that runs past `size`.
+struct CompressedBitmap
+{
+    uint16_t width;
+    uint16_t height;
+    const uint8_t* data;
+    size_t size;
+};
+
+namespace Rle
+{
+static constexpr uint8_t TYPE_MASK = 0xC0;
+static constexpr uint8_t LENGTH_MASK = 0x3F;
+static constexpr uint8_t LITERAL = 0x00;
+static constexpr uint8_t REPEAT = 0x40;
+static constexpr uint8_t ZEROS = 0x80;
+static constexpr uint8_t ONES = 0xC0;
+static constexpr int32_t MAX_RUN = LENGTH_MASK + 1;
+} // namespace Rle
+} // namespace SSD1306
@@ -2,7 +2,7 @@
 #include "font_base.hpp"
 
 // clang-format off
-static constexpr uint8_t ssd1306_font5x7[] = {
+inline constexpr uint8_t ssd1306_font5x7[] = {
     0x00, 0x00, 0x00, 0x00, 0x00,
     0x3E, 0x5B, 0x4F, 0x5B, 0x3E,
     0x3E, 0x6B, 0x4F, 0x6B, 0x3E,
@@ -265,29 +265,36 @@ static constexpr uint8_t ssd1306_font5x7[] = {
 class Font5x7 : public FontBase
 {
   public:
+    static constexpr uint8_t WIDTH = 5;
+    static constexpr uint8_t HEIGHT = 7;
+    static constexpr uint8_t CHARACTER_SPACE = 1;
+    static constexpr uint8_t CHARACTER_OFFSET = 0;
+    static constexpr uint16_t CHARACTER_COUNT = sizeof(ssd1306_font5x7) / WIDTH;
+    static constexpr const uint8_t* DATA = ssd1306_font5x7;
+
     uint8_t width() const override
     {
-        return 5;
+        return WIDTH;
     }
 
     uint8_t height() const override
     {
-        return 7;
+        return HEIGHT;
     }
 
     uint8_t characterSpace() const override
     {
-        return 1;
+        return CHARACTER_SPACE;
     }
 
     uint8_t characterOffset() const override
     {
-        return 0;
+        return CHARACTER_OFFSET;
     }
 
     const uint8_t* getFontData() const override
     {
-        return ssd1306_font5x7;
+        return DATA;
     }
 };
 
@@ -2,7 +2,7 @@
 #include "font_base.hpp"
 
 // clang-format off
-static constexpr uint8_t ssd1306_font5x8[] = {
+inline constexpr uint8_t ssd1306_font5x8[] = {
     0x00, 0x00, 0x00, 0x00, 0x00, // 0x20
     0x00, 0x00, 0x2F, 0x00, 0x00, // 0x21
     0x00, 0x03, 0x00, 0x03, 0x00, // 0x22
@@ -105,29 +105,36 @@ static constexpr uint8_t ssd1306_font5x8[] = {
 class Font5x8 : public FontBase
 {
   public:
+    static constexpr uint8_t WIDTH = 5;
+    static constexpr uint8_t HEIGHT = 8;
+    static constexpr uint8_t CHARACTER_SPACE = 1;
+    static constexpr uint8_t CHARACTER_OFFSET = 32;
+    static constexpr uint16_t CHARACTER_COUNT = sizeof(ssd1306_font5x8) / WIDTH;
+    static constexpr const uint8_t* DATA = ssd1306_font5x8;
+
     uint8_t width() const override
     {
-        return 5;
+        return WIDTH;
     }
 
     uint8_t height() const override
     {
-        return 8;
+        return HEIGHT;
     }
 
     uint8_t characterSpace() const override
     {
-        return 1;
+        return CHARACTER_SPACE;
     }
 
     uint8_t characterOffset() const override
     {
-        return 32;
+        return CHARACTER_OFFSET;
     }
 
     const uint8_t* getFontData() const override
     {
-        return ssd1306_font5x8;
+        return DATA;
     }
 };
 
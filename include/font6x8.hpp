@@ -2,7 +2,7 @@
 #include "font_base.hpp"
 
 // clang-format off
-static constexpr uint8_t ssd1306_font6x8[] = {
+inline constexpr uint8_t ssd1306_font6x8[] = {
      0x00,0x00,0x00,0x00,0x00,0x00,	// 0x20
      0x00,0x00,0x06,0x5F,0x06,0x00,	// 0x21
      0x00,0x07,0x03,0x00,0x07,0x03,	// 0x22
@@ -105,29 +105,36 @@ static constexpr uint8_t ssd1306_font6x8[] = {
 class Font6x8 : public FontBase
 {
   public:
+    static constexpr uint8_t WIDTH = 6;
+    static constexpr uint8_t HEIGHT = 8;
+    static constexpr uint8_t CHARACTER_SPACE = 1;
+    static constexpr uint8_t CHARACTER_OFFSET = 32;
+    static constexpr uint16_t CHARACTER_COUNT = sizeof(ssd1306_font6x8) / WIDTH;
+    static constexpr const uint8_t* DATA = ssd1306_font6x8;
+
     uint8_t width() const override
     {
-        return 6;
+        return WIDTH;
     }
 
     uint8_t height() const override
     {
-        return 8;
+        return HEIGHT;
     }
 
     uint8_t characterSpace() const override
     {
-        return 1;
+        return CHARACTER_SPACE;
     }
 
     uint8_t characterOffset() const override
     {
-        return 32;
+        return CHARACTER_OFFSET;
     }
 
     const uint8_t* getFontData() const override
     {
-        return ssd1306_font6x8;
+        return DATA;
     }
 };
 
@@ -7,6 +7,12 @@
 namespace Fonts
 {
 
+// Font classes for compile-time selection, e.g. drawText<Fonts::Font6x8>(x, y, text).
+using Font5x7 = ::Font5x7;
+using Font5x8 = ::Font5x8;
+using Font6x8 = ::Font6x8;
+using Font8x8 = ::Font8x8;
+
 enum class FontType
 {
     FONT5X7,
@@ -1,22 +1,61 @@
 #pragma once
 
-#include <boards/pico_w.h>
+#ifndef SSD1306_HOST_BUILD
+    #include <boards/pico_w.h>
+    #include <pico/types.h>
+#endif
 #include <cstdint>
-#include <pico/types.h>
 #include <stddef.h>
 #include <cstring>
 #include <sys/cdefs.h>
 #include <math.h>
 #include <string>
+#include <type_traits>
 
+#include "bitmap_convert.hpp"
+#include "compressed_bitmap.hpp"
 #include "fonts.hpp"
 
-#include "ssd1306_hw_driver.hpp"
+#ifdef SSD1306_HOST_BUILD
+    #include "ssd1306_hw_interface.hpp"
+#else
+    #include "ssd1306_hw_driver.hpp"
+#endif
 
 namespace SSD1306
 {
+// How source bits are combined with the frame buffer. Lines and shapes have no unlit source
+// pixels, so COPY draws them like SET.
+enum class DrawMode
+{
+    SET,   // Lit source pixels are set, the rest is left untouched (transparent)
+    COPY,  // Source pixels overwrite the covered area, unlit ones clear it (opaque)
+    XOR,   // Lit source pixels toggle the frame buffer
+    CLEAR  // Lit source pixels are cleared
+};
+
+// Time between two steps of the continuous hardware scroll, in frames. The values are the
+// register encoding of the SSD1306.
+enum class ScrollInterval : uint8_t
+{
+    FRAMES_2 = 0x07,
+    FRAMES_3 = 0x04,
+    FRAMES_4 = 0x05,
+    FRAMES_5 = 0x00,
+    FRAMES_25 = 0x06,
+    FRAMES_64 = 0x01,
+    FRAMES_128 = 0x02,
+    FRAMES_256 = 0x03
+};
+
+enum class ScrollDirection
+{
+    RIGHT,
+    LEFT
+};
 
-template<int32_t WIDTH, int32_t HEIGHT, bool FLIP_DIRECTION = false, bool INVERTED = false>
+template<int32_t WIDTH, int32_t HEIGHT, bool FLIP_DIRECTION = false, bool INVERTED = false,
+         bool DOUBLE_BUFFERED = false, bool DIFF_UPDATES = false, int32_t STRIP_PAGES = HEIGHT / 8>
 class OledDisplay
 {
   private:
@@ -39,6 +78,13 @@ class OledDisplay
     static constexpr uint8_t SSD1306_DISPLAYALLON_RESUME = 0xA4;
     static constexpr uint8_t SSD1306_NORMALDISPLAY = 0xA6;
     static constexpr uint8_t SSD1306_INVERTDISPLAY = 0xA7;
+    static constexpr uint8_t SSD1306_RIGHT_HORIZONTAL_SCROLL = 0x26;
+    static constexpr uint8_t SSD1306_LEFT_HORIZONTAL_SCROLL = 0x27;
+    static constexpr uint8_t SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL = 0x29;
+    static constexpr uint8_t SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL = 0x2A;
+    static constexpr uint8_t SSD1306_DEACTIVATE_SCROLL = 0x2E;
+    static constexpr uint8_t SSD1306_ACTIVATE_SCROLL = 0x2F;
+    static constexpr uint8_t SSD1306_SET_VERTICAL_SCROLL_AREA = 0xA3;
 
     enum class MEMORY_ADDRESSING_MODE
     {
@@ -53,326 +99,2232 @@ class OledDisplay
         FLIPPED = 0x08
     };
 
-    void drawChar(int32_t x, int32_t y, char c, FontBase* fontData)
+    static constexpr int32_t PAGES = HEIGHT / 8;
+    static constexpr int32_t BUFFER_SIZE = WIDTH * HEIGHT / 8;
+    static constexpr bool STRIP_MODE = STRIP_PAGES < PAGES;
+
+    void drawChar(int32_t x, int32_t y, char c, FontBase* fontData, DrawMode mode)
     {
         if(c < 0 || c > 255)
         {
             return;
         }
 
-        uint16_t index = (c - fontData->characterOffset()) * fontData->width();
-
-        for(int32_t i = 0; i < fontData->width(); ++i)
-        {
-            uint8_t col = fontData->getFontData()[index + i];
+        int32_t width = fontData->width();
+        int32_t height = fontData->height();
+        uint16_t index = (c - fontData->characterOffset()) * width;
+        markDirty(x, y, x + width - 1, y + height - 1);
 
-            for(int32_t j = 0; j < fontData->height(); ++j)
-            {
-                if(col & (1 << j))
-                {
-                    drawPixel(x + i, y + j);
-                }
-            }
-        }
+        blitColumns(x, y, &fontData->getFontData()[index], width, 0xFF >> (8 - height), mode);
     }
 
-  public:
-    OledDisplay()
+    template<DrawMode MODE>
+    static __always_inline uint8_t combine(uint8_t destination, uint8_t bits, uint8_t mask)
     {
-        static_assert(WIDTH > 0 && WIDTH % 8 == 0, "Width must be a multiple of 8");
-        static_assert(HEIGHT > 0 && HEIGHT % 8 == 0, "Height must be a multiple of 8");
-
-        hwInterface.initialize();
-        clear();
-
-        hwInterface.reset();
-
-        uint8_t mode = INVERTED ? SSD1306_INVERTDISPLAY : SSD1306_NORMALDISPLAY;
-
-        uint8_t segremapValue = 0x00;
-        uint8_t scanDirection = 0x00;
-        if constexpr(FLIP_DIRECTION)
+        if constexpr(MODE == DrawMode::COPY)
         {
-            segremapValue = SSD1306_SEGREMAP | 0x0;
-            scanDirection = SSD1306_COMSCANDEC | static_cast<uint8_t>(SCAN_DIRECTION::NORMAL);
+            return (destination & ~mask) | bits;
+        }
+        else if constexpr(MODE == DrawMode::XOR)
+        {
+            return destination ^ bits;
+        }
+        else if constexpr(MODE == DrawMode::CLEAR)
+        {
+            return destination & ~bits;
         }
         else
         {
-            segremapValue = SSD1306_SEGREMAP | 0x1;
-            scanDirection = SSD1306_COMSCANDEC | static_cast<uint8_t>(SCAN_DIRECTION::FLIPPED);
+            return destination | bits;
         }
-
-        uint8_t commands[] = {SSD1306_DISPLAYOFF,
-                              SSD1306_SETDISPLAYCLOCKDIV,
-                              0x80,
-                              SSD1306_SETMULTIPLEX,
-                              static_cast<uint8_t>(HEIGHT - 1),
-                              SSD1306_SETDISPLAYOFFSET,
-                              0x00,
-                              static_cast<uint8_t>(SSD1306_SETSTARTLINE | 0x00),
-                              SSD1306_CHARGEPUMP,
-                              0x14,
-                              SSD1306_MEMORYMODE,
-                              static_cast<uint8_t>(MEMORY_ADDRESSING_MODE::HORIZONTAL),
-                              segremapValue,
-                              scanDirection,
-                              SSD1306_SETCOMPINS,
-                              0x12,
-                              SSD1306_SETCONTRAST,
-                              0x00,
-                              SSD1306_SETPRECHARGE,
-                              0xF1,
-                              SSD1306_SETVCOMDETECT,
-                              0x40,
-                              SSD1306_DISPLAYALLON_RESUME,
-                              mode,
-                              SSD1306_DISPLAYON};
-        hwInterface.sendCommands(commands, sizeof(commands));
     }
 
-    constexpr int32_t width() const
+    // Any mode applied to the lit bits of value within mask comes down to
+    // destination = (destination & ~clearBits) ^ toggleBits, which fills apply a word at a time.
+    struct PixelOp
     {
-        return WIDTH;
+        uint8_t clearBits;
+        uint8_t toggleBits;
+    };
+
+    static PixelOp pixelOp(DrawMode mode, uint8_t value, uint8_t mask)
+    {
+        value &= mask;
+        switch(mode)
+        {
+            case DrawMode::COPY:
+                return {mask, value};
+            case DrawMode::XOR:
+                return {0x00, value};
+            case DrawMode::CLEAR:
+                return {value, 0x00};
+            default:
+                return {value, value};
+        }
     }
 
-    constexpr int32_t height() const
+    // Lines and shapes only have lit pixels.
+    static __always_inline PixelOp pixelOp(DrawMode mode, uint8_t bits)
     {
-        return HEIGHT;
+        return {mode == DrawMode::XOR ? uint8_t(0x00) : bits,
+                mode == DrawMode::CLEAR ? uint8_t(0x00) : bits};
     }
 
-    void clear()
+    static __always_inline void apply(uint8_t& destination, PixelOp op)
     {
-        memset(buffer, 0x00, sizeof(buffer));
+        destination = (destination & ~op.clearBits) ^ op.toggleBits;
     }
 
-    void display()
+    // Offset of frame page page in the buffer. In strip mode the buffer only holds the pages from
+    // stripFirstPage on, and the clip rectangle keeps drawing on those.
+    __always_inline int32_t pageRow(int32_t page) const
     {
-        uint8_t commands[] = {SSD1306_COLUMNADDR, 0x00, static_cast<uint8_t>(WIDTH - 1),
-                              SSD1306_PAGEADDR,   0x00, static_cast<uint8_t>((HEIGHT / 8) - 1)};
-        hwInterface.sendCommands(commands, sizeof(commands));
-        hwInterface.sendDataBulk(buffer, sizeof(buffer));
+        return (STRIP_MODE ? page - stripFirstPage : page) * WIDTH;
     }
 
-    __always_inline void drawPixel(int32_t x, int32_t y)
+    // Limits a strip of up to 8 rows starting at buffer row y to the clip rectangle.
+    uint8_t clipRowMask(int32_t y, uint8_t mask) const
     {
-        if(x >= WIDTH || y >= HEIGHT)
+        int32_t above = clipping.y0 - y;
+        if(above > 0)
         {
-            return;
+            mask = above >= 8 ? 0 : mask & (0xFF << above);
+        }
+        int32_t below = y + 7 - clipping.y1;
+        if(below > 0)
+        {
+            mask = below >= 8 ? 0 : mask & (0xFF >> below);
         }
-        buffer[x + ((y >> 3) * WIDTH)] |= 1 << (y & 7);
+        return mask;
     }
 
-    void drawChar(int32_t x, int32_t y, char c, Fonts::FontType font = Fonts::FontType::FONT5X8)
+    // Writes a strip of column bytes (LSB at the top, at most 8 pixels tall given by mask) into
+    // the buffer. Bitmap, font and page layouts match, so each column is one shifted byte, split
+    // over two pages when y is not page aligned. Clipping is decided once for the whole strip:
+    // the columns are cut to the clip rectangle and the rows outside it are dropped from mask.
+    template<DrawMode MODE = DrawMode::SET>
+    __always_inline void blitColumns(int32_t x, int32_t y, const uint8_t* columns, int32_t count,
+                                     uint8_t mask)
     {
-        auto fontData = getFont(font);
-        drawChar(x, y, c, fontData);
-    }
+        x += clipping.originX;
+        y += clipping.originY;
+        int32_t first = x < clipping.x0 ? clipping.x0 - x : 0;
+        int32_t last = x + count > clipping.x1 + 1 ? clipping.x1 + 1 - x : count;
+        mask = clipRowMask(y, mask);
+        if(first >= last || mask == 0)
+        {
+            return;
+        }
 
-    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
-    {
-        int32_t dx = abs(x1 - x0);
-        int32_t sx = x0 < x1 ? 1 : -1;
-        int32_t dy = -abs(y1 - y0);
-        int32_t sy = y0 < y1 ? 1 : -1;
-        int32_t err = dx + dy;
+        int32_t page = y >> 3;
+        int32_t shift = y & 7;
+        int32_t upper = x + pageRow(page);
+        int32_t lower = upper + WIDTH;
 
-        while(true)
+        if(MODE == DrawMode::COPY && shift == 0 && mask == 0xFF)
         {
-            drawPixel(x0, y0);
-            if(x0 == x1 && y0 == y1)
-                break;
+            memcpy(&buffer[upper + first], &columns[first], last - first);
+            return;
+        }
 
-            int e2 = 2 * err;
-            if(e2 >= dy)
+        // Only pages holding rows inside the clip rectangle get a non-zero mask.
+        uint8_t upperMask = mask << shift;
+        uint8_t lowerMask = shift != 0 ? mask >> (8 - shift) : 0;
+        for(int32_t i = first; i < last; ++i)
+        {
+            uint8_t bits = columns[i] & mask;
+            if(upperMask != 0)
             {
-                err += dy;
-                x0 += sx;
+                buffer[upper + i] = combine<MODE>(buffer[upper + i], bits << shift, upperMask);
             }
-            if(e2 <= dx)
+            if(lowerMask != 0)
             {
-                err += dx;
-                y0 += sy;
+                buffer[lower + i] =
+                    combine<MODE>(buffer[lower + i], bits >> (8 - shift), lowerMask);
             }
         }
     }
 
-    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h)
+    void blitColumns(int32_t x, int32_t y, const uint8_t* columns, int32_t count, uint8_t mask,
+                     DrawMode mode)
     {
-        for(int32_t i = x; i < x + w; i++)
+        switch(mode)
         {
-            for(int32_t j = y; j < y + h; j++)
-            {
-                drawPixel(i, j);
-            }
+            case DrawMode::COPY:
+                blitColumns<DrawMode::COPY>(x, y, columns, count, mask);
+                break;
+            case DrawMode::XOR:
+                blitColumns<DrawMode::XOR>(x, y, columns, count, mask);
+                break;
+            case DrawMode::CLEAR:
+                blitColumns<DrawMode::CLEAR>(x, y, columns, count, mask);
+                break;
+            default:
+                blitColumns<DrawMode::SET>(x, y, columns, count, mask);
+                break;
         }
     }
 
-    void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+    // Blits a row-major bitmap one 8x8 tile at a time, transposed into column bytes.
+    template<DrawMode MODE>
+    void blitRowMajorBitmap(int32_t x, int32_t y, const uint8_t* bitmap, int32_t w, int32_t h)
     {
-        auto swap = [](int32_t& a, int32_t& b) {
-            int32_t t = a;
-            a = b;
-            b = t;
-        };
+        size_t bytesPerRow = (w + 7) / 8;
+        int32_t left = x + clipping.originX;
+        int32_t firstTile = left < clipping.x0 ? (clipping.x0 - left) / 8 : 0;
+        int32_t lastTile =
+            left + w > clipping.x1 + 1 ? (clipping.x1 + 1 - left + 7) / 8 : (w + 7) / 8;
 
-        if(y0 > y1)
+        for(int32_t row = 0; row * 8 < h; ++row)
         {
-            swap(y0, y1);
-            swap(x0, x1);
+            int32_t top = y + row * 8;
+            int32_t bufferTop = top + clipping.originY;
+            if(bufferTop <= clipping.y0 - 8 || bufferTop > clipping.y1)
+            {
+                continue;
+            }
+
+            int32_t rowCount = h - row * 8;
+            uint8_t mask = rowCount >= 8 ? 0xFF : 0xFF >> (8 - rowCount);
+            const uint8_t* source = &bitmap[row * 8 * bytesPerRow];
+
+            for(int32_t tile = firstTile; tile < lastTile; ++tile)
+            {
+                uint8_t columns[8];
+                transposeTile(&source[tile], bytesPerRow, rowCount, columns);
+
+                int32_t count = w - tile * 8 < 8 ? w - tile * 8 : 8;
+                blitColumns<MODE>(x + tile * 8, top, columns, count, mask);
+            }
         }
+    }
 
-        if(y1 > y2)
+    // Blits a bitmap in page layout one page row at a time.
+    template<DrawMode MODE>
+    void blitBitmap(int32_t x, int32_t y, const uint8_t* bitmap, int32_t w, int32_t h)
+    {
+        for(int32_t row = 0; row * 8 < h; ++row)
         {
-            swap(y1, y2);
-            swap(x1, x2);
+            int32_t remaining = h - row * 8;
+            uint8_t mask = remaining >= 8 ? 0xFF : 0xFF >> (8 - remaining);
+            blitColumns<MODE>(x, y + row * 8, &bitmap[row * w], w, mask);
         }
+    }
 
-        if(y0 > y1)
+    // Same as blitColumns for a run of identical column bytes, written as masked span fills.
+    void fillColumns(int32_t x, int32_t y, uint8_t value, int32_t count, uint8_t mask,
+                     DrawMode mode)
+    {
+        x += clipping.originX;
+        y += clipping.originY;
+        mask = clipRowMask(y, mask);
+        int32_t first = x < clipping.x0 ? clipping.x0 : x;
+        int32_t last = x + count > clipping.x1 + 1 ? clipping.x1 + 1 : x + count;
+        if(mask == 0 || first >= last)
         {
-            swap(y0, y1);
-            swap(x0, x1);
+            return;
         }
 
-        int32_t total_height = y2 - y0;
-
-        for(int32_t i = 0; i < total_height; i++)
+        int32_t page = y >> 3;
+        int32_t shift = y & 7;
+        uint8_t upperMask = mask << shift;
+        uint8_t lowerMask = shift != 0 ? mask >> (8 - shift) : 0;
+        if(upperMask != 0)
         {
-            bool second_half = i > y1 - y0 || y1 == y0;
-            int32_t segment_height = second_half ? y2 - y1 : y1 - y0;
-            float alpha = (float)i / total_height;
-            float beta = (float)(i - (second_half ? y1 - y0 : 0)) / segment_height;
-
-            int32_t ax = x0 + (x2 - x0) * alpha;
-            int32_t bx = second_half ? x1 + (x2 - x1) * beta : x0 + (x1 - x0) * beta;
+            fillPageSpan(&buffer[first + pageRow(page)], last - first,
+                         pixelOp(mode, value << shift, upperMask));
+        }
+        if(lowerMask != 0)
+        {
+            fillPageSpan(&buffer[first + pageRow(page + 1)], last - first,
+                         pixelOp(mode, value >> (8 - shift), lowerMask));
+        }
+    }
 
-            if(ax > bx)
+    // Walks the intersection of a triangle edge with consecutive pixel rows in integer steps.
+    // x is the first pixel column at or right of the intersection, which is the first covered
+    // column for a left edge and one past the last covered one for a right edge.
+    struct TriangleEdge
+    {
+        TriangleEdge(int32_t xa, int32_t ya, int32_t xb, int32_t yb, int32_t row)
+        {
+            dy = yb - ya;
+            if(dy <= 0)
             {
-                swap(ax, bx);
+                x = xa;
+                return;
             }
 
-            for(int32_t j = ax; j <= bx; j++)
+            int32_t dx = xb - xa;
+            quotient = dx >= 0 ? dx / dy : -((-dx + dy - 1) / dy);
+            remainder = dx - quotient * dy;
+
+            // Exact intersection at the starting row is xa + (row - ya) * dx / dy.
+            int64_t numerator = static_cast<int64_t>(row - ya) * dx;
+            int64_t ceiling = numerator >= 0 ? (numerator + dy - 1) / dy : -(-numerator / dy);
+            x = xa + static_cast<int32_t>(ceiling);
+            error = static_cast<int32_t>(ceiling * dy - numerator);
+        }
+
+        void step()
+        {
+            x += quotient;
+            error -= remainder;
+            if(error < 0)
             {
-                drawPixel(j, y0 + i);
+                ++x;
+                error += dy;
             }
         }
-    }
 
-    void drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+        int32_t x = 0;
+        int32_t dy = 0;
+        int32_t quotient = 0;
+        int32_t remainder = 0;
+        int32_t error = 0;
+    };
+
+    __always_inline void setPixel(int32_t x, int32_t y, DrawMode mode)
     {
-        drawLine(x0, y0, x1, y1);
-        drawLine(x1, y1, x2, y2);
-        drawLine(x2, y2, x0, y0);
+        x += clipping.originX;
+        y += clipping.originY;
+        if(x < clipping.x0 || x > clipping.x1 || y < clipping.y0 || y > clipping.y1)
+        {
+            return;
+        }
+        apply(buffer[x + pageRow(y >> 3)], pixelOp(mode, 1 << (y & 7)));
     }
 
-    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h)
+    static int64_t floorDiv(int64_t numerator, int64_t denominator)
     {
-        drawLine(x, y, x + w - 1, y);
-        drawLine(x, y + h - 1, x + w - 1, y + h - 1);
-        drawLine(x, y, x, y + h - 1);
-        drawLine(x + w - 1, y, x + w - 1, y + h - 1);
+        return numerator >= 0 ? numerator / denominator
+                              : -((-numerator + denominator - 1) / denominator);
     }
 
-    void drawCircle(int32_t x0, int32_t y0, int32_t radius)
+    // Bresenham state at the first pixel inside the clip rectangle.
+    struct LineWalk
     {
-        int32_t x = radius;
-        int32_t y = 0;
-        int32_t err = 0;
+        int32_t major;
+        int32_t minor;
+        int32_t majorStep;
+        int32_t minorStep;
+        int32_t remainder;
+        int32_t increment;
+        int32_t limit;
+        int32_t count;
+    };
 
-        while(x >= y)
-        {
-            drawPixel(x0 + x, y0 + y);
-            drawPixel(x0 + y, y0 + x);
-            drawPixel(x0 - y, y0 + x);
-            drawPixel(x0 - x, y0 + y);
-            drawPixel(x0 - x, y0 - y);
-            drawPixel(x0 - y, y0 - x);
-            drawPixel(x0 + y, y0 - x);
-            drawPixel(x0 + x, y0 - y);
+    // Bresenham line in buffer coordinates. Pixel t of the line lies t steps along the major
+    // axis and floor((2 * t * minor + major) / (2 * major)) steps along the minor one, so the
+    // range of t inside the clip rectangle and the error term at its start follow directly.
+    // The loop then writes without bounds checks and yields exactly the pixels of the unclipped
+    // line that fall inside the clip rectangle. Without withEnd the line stops one pixel short of
+    // x1, y1, so that joined segments share no pixel.
+    void plotLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, DrawMode mode, bool withEnd)
+    {
+        int64_t dx = static_cast<int64_t>(x1) - x0;
+        int64_t dy = static_cast<int64_t>(y1) - y0;
+        bool steep = (dy < 0 ? -dy : dy) > (dx < 0 ? -dx : dx);
+        int64_t majorDelta = steep ? dy : dx;
+        int64_t minorDelta = steep ? dx : dy;
+        int32_t majorStep = majorDelta < 0 ? -1 : 1;
+        int32_t minorStep = minorDelta < 0 ? -1 : 1;
+        int64_t major = majorDelta * majorStep;
+        int64_t minor = minorDelta * minorStep;
+        int32_t majorStart = steep ? y0 : x0;
+        int32_t minorStart = steep ? x0 : y0;
 
-            y++;
-            if(err <= 0)
-            {
-                err += 2 * y + 1;
-            }
-            else
+        // Offsets from the start that keep a coordinate within low..high.
+        auto offsets = [](int64_t start, int32_t step, int64_t low, int64_t high, int64_t& first,
+                          int64_t& last) {
+            first = step > 0 ? low - start : start - high;
+            last = step > 0 ? high - start : start - low;
+        };
+        int64_t firstStep;
+        int64_t lastStep;
+        offsets(majorStart, majorStep, steep ? clipping.y0 : clipping.x0,
+                steep ? clipping.y1 : clipping.x1, firstStep, lastStep);
+        int64_t end = withEnd ? major : major - 1;
+        firstStep = firstStep > 0 ? firstStep : 0;
+        lastStep = lastStep < end ? lastStep : end;
+
+        int64_t firstOffset;
+        int64_t lastOffset;
+        offsets(minorStart, minorStep, steep ? clipping.x0 : clipping.y0,
+                steep ? clipping.x1 : clipping.y1, firstOffset, lastOffset);
+        if(minor == 0)
+        {
+            if(firstOffset > 0 || lastOffset < 0)
             {
-                x--;
-                err += 2 * (y - x) + 1;
+                return;
             }
         }
+        else
+        {
+            int64_t first = -floorDiv(major - 2 * major * firstOffset, 2 * minor);
+            int64_t last = floorDiv(2 * major * (lastOffset + 1) - major - 1, 2 * minor);
+            firstStep = first > firstStep ? first : firstStep;
+            lastStep = last < lastStep ? last : lastStep;
+        }
+        if(firstStep > lastStep)
+        {
+            return;
+        }
+
+        int64_t numerator = 2 * firstStep * minor + major;
+        LineWalk walk = {majorStart + static_cast<int32_t>(firstStep) * majorStep,
+                         minorStart + static_cast<int32_t>(numerator / (2 * major)) * minorStep,
+                         majorStep,
+                         minorStep,
+                         static_cast<int32_t>(numerator % (2 * major)),
+                         static_cast<int32_t>(2 * minor),
+                         static_cast<int32_t>(2 * major),
+                         static_cast<int32_t>(lastStep - firstStep) + 1};
+        if(steep)
+        {
+            walkLine<true>(walk, mode);
+        }
+        else
+        {
+            walkLine<false>(walk, mode);
+        }
     }
 
-    template<typename StringType>
-    void drawText(int32_t x, int32_t y, const StringType& text,
-                  Fonts::FontType font = Fonts::FontType::FONT5X8)
+    template<bool STEEP>
+    void walkLine(const LineWalk& walk, DrawMode mode)
     {
-        auto fontData = getFont(font);
-        for(auto c: text)
+        switch(mode)
         {
-            if(c == '\0')
-            {
+            case DrawMode::XOR:
+                walkLine<STEEP, DrawMode::XOR>(walk);
+                break;
+            case DrawMode::CLEAR:
+                walkLine<STEEP, DrawMode::CLEAR>(walk);
+                break;
+            default:
+                walkLine<STEEP, DrawMode::SET>(walk);
                 break;
-            }
-            drawChar(x, y, c, fontData);
-            x += fontData->width() + fontData->characterSpace();
         }
     }
 
-    template<typename StringType>
-    void drawTextWithWrap(int32_t x, int32_t y, const StringType& text,
-                          Fonts::FontType font = Fonts::FontType::FONT5X8)
+    template<bool STEEP, DrawMode MODE>
+    void walkLine(const LineWalk& walk)
     {
-        auto fontData = getFont(font);
-        for(auto c: text)
+        int32_t major = walk.major;
+        int32_t minor = walk.minor;
+        int32_t remainder = walk.remainder;
+        for(int32_t count = walk.count; count > 0; --count)
         {
-            if(c == '\0')
+            int32_t x = STEEP ? minor : major;
+            int32_t y = STEEP ? major : minor;
+            uint8_t bit = 1 << (y & 7);
+            uint8_t& destination = buffer[x + pageRow(y >> 3)];
+            destination = combine<MODE>(destination, bit, bit);
+            major += walk.majorStep;
+            remainder += walk.increment;
+            if(remainder >= walk.limit)
             {
-                break;
-            }
-            drawChar(x, y, c, fontData);
-            x += fontData->width() + fontData->characterSpace();
-            if(x + fontData->width() > WIDTH)
-            {
-                x = 0;
-                y += fontData->height() + 1;
+                remainder -= walk.limit;
+                minor += walk.minorStep;
             }
         }
     }
 
-    void drawBitmap(int x, int y, const uint8_t* bitmap, int w, int h)
+    // Applies a pixel operation to a run of bytes within one page, using word stores once
+    // aligned.
+    static void fillPageSpan(uint8_t* row, int32_t length, PixelOp op)
     {
-        for(int j = 0; j < h; j++)
+        if(op.clearBits == 0xFF && (op.toggleBits == 0x00 || op.toggleBits == 0xFF))
         {
-            for(int i = 0; i < w; i++)
-            {
-                int byteIndex = i + (j / 8) * w;
-                if(bitmap[byteIndex] & (1 << (j % 8)))
-                {
-                    drawPixel(x + i, y + j);
-                }
-            }
+            memset(row, op.toggleBits, length);
+            return;
+        }
+        if(op.clearBits == 0x00 && op.toggleBits == 0x00)
+        {
+            return;
+        }
+
+        for(; length > 0 && (reinterpret_cast<uintptr_t>(row) & 3) != 0; --length, ++row)
+        {
+            apply(*row, op);
+        }
+
+        uint32_t clearWord = op.clearBits * 0x01010101u;
+        uint32_t toggleWord = op.toggleBits * 0x01010101u;
+        for(; length >= 4; length -= 4, row += 4)
+        {
+            uint32_t word;
+            memcpy(&word, __builtin_assume_aligned(row, 4), sizeof(word));
+            word = (word & ~clearWord) ^ toggleWord;
+            memcpy(__builtin_assume_aligned(row, 4), &word, sizeof(word));
+        }
+
+        for(; length > 0; --length, ++row)
+        {
+            apply(*row, op);
         }
     }
 
-    void drawBitmapHorizontal(int x0, int y0, const uint8_t* bitmap, int width, int height)
+    // Builds a run of column bytes that start offset rows into the upper page, taking the rest
+    // from the lower page. Four columns are shifted per word; a missing page reads as empty.
+    static void shiftColumns(uint8_t* out, const uint8_t* upper, const uint8_t* lower,
+                             int32_t length, int32_t offset)
     {
-        int bytesPerRow = (width + 7) / 8;
+        static constexpr uint8_t EMPTY[WIDTH] = {};
+        upper = upper != nullptr ? upper : EMPTY;
+        lower = lower != nullptr && offset != 0 ? lower : EMPTY;
 
-        for(int y = 0; y < height; y++)
+        uint32_t upperMask = (0xFFu >> offset) * 0x01010101u;
+        int32_t i = 0;
+        for(; i + 4 <= length; i += 4)
         {
-            for(int x = 0; x < width; x++)
-            {
-                int byteIndex = y * bytesPerRow + (x / 8);
-                uint8_t bit = bitmap[byteIndex] & (0x80 >> (x % 8));
+            uint32_t high;
+            uint32_t low;
+            memcpy(&high, &upper[i], sizeof(high));
+            memcpy(&low, &lower[i], sizeof(low));
+            uint32_t word = ((high >> offset) & upperMask) | ((low << (8 - offset)) & ~upperMask);
+            memcpy(&out[i], &word, sizeof(word));
+        }
+        for(; i < length; ++i)
+        {
+            out[i] = (upper[i] >> offset) | (lower[i] << (8 - offset));
+        }
+    }
+
+    // Opaque text also clears the spacing left of a character that follows another one.
+    void clearSpacing(int32_t x, int32_t y, int32_t space, int32_t height, DrawMode mode)
+    {
+        if(mode != DrawMode::COPY || space <= 0)
+        {
+            return;
+        }
+        markDirty(x - space, y, x - 1, y + height - 1);
+        fillArea(x - space, y, x - 1, y + height - 1, DrawMode::CLEAR);
+    }
+
+    // Line in viewport coordinates; see plotLine() for withEnd.
+    void strokeLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, DrawMode mode, bool withEnd)
+    {
+        int32_t end = withEnd ? 0 : 1;
+        if(y0 == y1)
+        {
+            fillSpan(x0 < x1 ? x0 : x1 + end, x0 < x1 ? x1 - end : x0, y0, mode);
+            return;
+        }
+        if(x0 == x1)
+        {
+            fillColumn(x0, y0 < y1 ? y0 : y1 + end, y0 < y1 ? y1 - end : y0, mode);
+            return;
+        }
+        plotLine(x0 + clipping.originX, y0 + clipping.originY, x1 + clipping.originX,
+                 y1 + clipping.originY, mode, withEnd);
+    }
+
+    // Columns first..last of row y that strokeLine(x0, y0, x1, y1, mode, false) draws, in
+    // viewport coordinates. Every edge covers one run per row. Returns false if it misses row y.
+    static bool edgeRun(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t y, int32_t& first,
+                        int32_t& last)
+    {
+        int64_t across = static_cast<int64_t>(x1) - x0;
+        int64_t along = static_cast<int64_t>(y1) - y0;
+        int64_t offset = static_cast<int64_t>(y) - y0;
+        int32_t stepX = across < 0 ? -1 : 1;
+        across = across < 0 ? -across : across;
+        if(along < 0)
+        {
+            along = -along;
+            offset = -offset;
+        }
 
-                if(bit)
-                    drawPixel(x0 + x, y0 + y);
+        int64_t firstStep;
+        int64_t lastStep;
+        if(along > across)
+        {
+            // Steep: one pixel per row, rounded as in plotLine().
+            if(offset < 0 || offset >= along)
+            {
+                return false;
+            }
+            firstStep = lastStep = (2 * offset * across + along) / (2 * along);
+        }
+        else
+        {
+            if(offset < 0 || offset > along)
+            {
+                return false;
+            }
+            firstStep = 0;
+            lastStep = across - 1;
+            if(along > 0)
+            {
+                int64_t rowFirst = -floorDiv(across - 2 * across * offset, 2 * along);
+                int64_t rowLast = floorDiv(2 * across * (offset + 1) - across - 1, 2 * along);
+                firstStep = rowFirst > firstStep ? rowFirst : firstStep;
+                lastStep = rowLast < lastStep ? rowLast : lastStep;
+            }
+            if(firstStep > lastStep)
+            {
+                return false;
             }
         }
+
+        first = x0 + stepX * static_cast<int32_t>(stepX < 0 ? lastStep : firstStep);
+        last = x0 + stepX * static_cast<int32_t>(stepX < 0 ? firstStep : lastStep);
+        return true;
     }
 
-  private:
-    SSD1306::HardwareInterfaceBase& hwInterface = *new SSD1306::SPIInterface();
-    uint8_t buffer[WIDTH * HEIGHT / 8];
-};
+    // Cuts the inclusive buffer coordinate range first..last to the clip rectangle. Returns false
+    // if nothing of it is left.
+    bool clipColumns(int32_t& first, int32_t& last) const
+    {
+        first = first < clipping.x0 ? clipping.x0 : first;
+        last = last > clipping.x1 ? clipping.x1 : last;
+        return first <= last;
+    }
+
+    bool clipRows(int32_t& first, int32_t& last) const
+    {
+        first = first < clipping.y0 ? clipping.y0 : first;
+        last = last > clipping.y1 ? clipping.y1 : last;
+        return first <= last;
+    }
+
+    // Draws every pixel of the rectangle given by its inclusive corners. Clipping is done once up
+    // front, after which whole page bytes are written with top and bottom masks.
+    void fillArea(int32_t x0, int32_t y0, int32_t x1, int32_t y1, DrawMode mode)
+    {
+        x0 += clipping.originX;
+        y0 += clipping.originY;
+        x1 += clipping.originX;
+        y1 += clipping.originY;
+        if(!clipColumns(x0, x1) || !clipRows(y0, y1))
+        {
+            return;
+        }
+
+        int32_t firstPage = y0 >> 3;
+        int32_t lastPage = y1 >> 3;
+        for(int32_t page = firstPage; page <= lastPage; ++page)
+        {
+            uint8_t mask = 0xFF;
+            if(page == firstPage)
+            {
+                mask &= 0xFF << (y0 & 7);
+            }
+            if(page == lastPage)
+            {
+                mask &= 0xFF >> (7 - (y1 & 7));
+            }
+            fillPageSpan(&buffer[x0 + pageRow(page)], x1 - x0 + 1, pixelOp(mode, mask));
+        }
+    }
+
+    __always_inline void fillSpan(int32_t x0, int32_t x1, int32_t y, DrawMode mode)
+    {
+        x0 += clipping.originX;
+        x1 += clipping.originX;
+        y += clipping.originY;
+        if(y < clipping.y0 || y > clipping.y1 || !clipColumns(x0, x1))
+        {
+            return;
+        }
+
+        fillPageSpan(&buffer[x0 + pageRow(y >> 3)], x1 - x0 + 1, pixelOp(mode, 1 << (y & 7)));
+    }
+
+    // Draws the pixels of column x from row y0 to y1 (inclusive), one masked byte per page.
+    __always_inline void fillColumn(int32_t x, int32_t y0, int32_t y1, DrawMode mode)
+    {
+        x += clipping.originX;
+        y0 += clipping.originY;
+        y1 += clipping.originY;
+        if(x < clipping.x0 || x > clipping.x1 || !clipRows(y0, y1))
+        {
+            return;
+        }
+
+        uint8_t* column = &buffer[x];
+        int32_t firstPage = y0 >> 3;
+        int32_t lastPage = y1 >> 3;
+        uint8_t topMask = 0xFF << (y0 & 7);
+        uint8_t bottomMask = 0xFF >> (7 - (y1 & 7));
+        if(firstPage == lastPage)
+        {
+            apply(column[pageRow(firstPage)], pixelOp(mode, topMask & bottomMask));
+            return;
+        }
+
+        apply(column[pageRow(firstPage)], pixelOp(mode, topMask));
+        if(mode == DrawMode::XOR)
+        {
+            for(int32_t page = firstPage + 1; page < lastPage; ++page)
+            {
+                column[pageRow(page)] ^= 0xFF;
+            }
+        }
+        else
+        {
+            uint8_t fill = mode == DrawMode::CLEAR ? 0x00 : 0xFF;
+            for(int32_t page = firstPage + 1; page < lastPage; ++page)
+            {
+                column[pageRow(page)] = fill;
+            }
+        }
+        apply(column[pageRow(lastPage)], pixelOp(mode, bottomMask));
+    }
+
+    // Outline of a circle whose quadrants are drawn around separate centres: the right half
+    // around column right, the left half around column left, the lower half around row bottom
+    // and the upper half around row top. A circle passes one centre four times, a rounded
+    // rectangle its corner centres. The midpoint algorithm walks one octant, and the pixels that
+    // share its x form a run, written as vertical spans in the steep octants and as horizontal
+    // spans in the flat ones. No pixel is written twice, which XOR would undo: the flat runs stop
+    // short of the diagonal, and where two centres coincide the upper and left copies leave out
+    // the shared centre row and column.
+    void strokeArcs(int32_t left, int32_t top, int32_t right, int32_t bottom, int32_t radius,
+                    DrawMode mode)
+    {
+        int32_t sharedRow = top == bottom ? 1 : 0;
+        int32_t sharedColumn = left == right ? 1 : 0;
+        int32_t x = radius;
+        int32_t y = 0;
+        int32_t err = 0;
+        int32_t first = 0;
+
+        while(x >= y)
+        {
+            int32_t runX = x;
+            int32_t last = y;
+            y++;
+            if(err <= 0)
+            {
+                err += 2 * y + 1;
+            }
+            else
+            {
+                x--;
+                err += 2 * (y - x) + 1;
+            }
+            if(x == runX && x >= y)
+            {
+                continue;
+            }
+
+            int32_t upperFirst = first > sharedRow ? first : sharedRow;
+            fillColumn(right + runX, bottom + first, bottom + last, mode);
+            fillColumn(right + runX, top - last, top - upperFirst, mode);
+            if(runX >= sharedColumn)
+            {
+                fillColumn(left - runX, bottom + first, bottom + last, mode);
+                fillColumn(left - runX, top - last, top - upperFirst, mode);
+            }
+
+            int32_t spanLast = last < runX ? last : runX - 1;
+            int32_t leftFirst = first > sharedColumn ? first : sharedColumn;
+            fillSpan(right + first, right + spanLast, bottom + runX, mode);
+            fillSpan(left - spanLast, left - leftFirst, bottom + runX, mode);
+            fillSpan(right + first, right + spanLast, top - runX, mode);
+            fillSpan(left - spanLast, left - leftFirst, top - runX, mode);
+            first = y;
+        }
+    }
+
+    // Interior of the shape outlined by strokeArcs, including the band between the centres,
+    // written as one vertical span per column.
+    void fillArcs(int32_t left, int32_t top, int32_t right, int32_t bottom, int32_t radius,
+                  DrawMode mode)
+    {
+        fillArea(left, top - radius, right, bottom + radius, mode);
+
+        int32_t x = radius;
+        int32_t y = 0;
+        int32_t err = 0;
+        while(x >= y)
+        {
+            // Columns y away from the centres reach x rows out, the columns x away reach as far
+            // as the last y of their run. The band covers the centre columns, and a run ending on
+            // the diagonal has already been written as a y column.
+            if(y > 0)
+            {
+                fillColumn(right + y, top - x, bottom + x, mode);
+                fillColumn(left - y, top - x, bottom + x, mode);
+            }
+
+            int32_t runX = x;
+            int32_t last = y;
+            y++;
+            if(err <= 0)
+            {
+                err += 2 * y + 1;
+            }
+            else
+            {
+                x--;
+                err += 2 * (y - x) + 1;
+            }
+            if((x != runX || x < y) && last < runX)
+            {
+                fillColumn(right + runX, top - last, bottom + last, mode);
+                fillColumn(left - runX, top - last, bottom + last, mode);
+            }
+        }
+    }
+
+    // Walks one quadrant of an axis-aligned ellipse with the integer midpoint algorithm (error
+    // terms after A. Zingl), calling visit(dx, dy) for every outline pixel from (rx, 0) to
+    // (0, ry). Each step moves dx down, dy up or both. The error terms grow with the cube of the
+    // radii; 32 bits hold them up to radii of 512, so only larger ellipses pay for 64-bit
+    // arithmetic on the Cortex-M0+.
+    template<typename Visit>
+    static void walkEllipse(int32_t rx, int32_t ry, Visit visit)
+    {
+        if(rx <= 512 && ry <= 512)
+        {
+            walkQuadrant<int32_t>(rx, ry, visit);
+        }
+        else
+        {
+            walkQuadrant<int64_t>(rx, ry, visit);
+        }
+    }
+
+    template<typename Int, typename Visit>
+    static void walkQuadrant(int32_t rx, int32_t ry, Visit& visit)
+    {
+        Int a2 = static_cast<Int>(rx) * rx;
+        Int b2 = static_cast<Int>(ry) * ry;
+        Int x = -rx;
+        Int y = 0;
+        Int err = x * (2 * b2 + x) + b2;
+
+        do
+        {
+            visit(static_cast<int32_t>(-x), static_cast<int32_t>(y));
+            Int e2 = 2 * err;
+            if(e2 >= (x * 2 + 1) * b2)
+            {
+                ++x;
+                err += (x * 2 + 1) * b2;
+            }
+            if(e2 <= (y * 2 + 1) * a2)
+            {
+                ++y;
+                err += (y * 2 + 1) * a2;
+            }
+        } while(x <= 0);
+
+        // Very flat ellipses stop early; finish the tip.
+        while(y < ry)
+        {
+            ++y;
+            visit(0, static_cast<int32_t>(y));
+        }
+    }
+
+    // Writes a run of ellipse outline pixels, either the row dy0 from dx0 to dx1 or the column
+    // dx0 from dy0 to dy1, mirrored into all four quadrants around the centre. The upper and left
+    // copies leave out the centre row and column, which the lower right one already covers.
+    void mirrorRun(int32_t cx, int32_t cy, int32_t dx0, int32_t dy0, int32_t dx1, int32_t dy1,
+                   DrawMode mode)
+    {
+        if(dy0 == dy1)
+        {
+            int32_t inner = dx0 > 0 ? dx0 : 1;
+            fillSpan(cx + dx0, cx + dx1, cy + dy0, mode);
+            fillSpan(cx - dx1, cx - inner, cy + dy0, mode);
+            if(dy0 > 0)
+            {
+                fillSpan(cx + dx0, cx + dx1, cy - dy0, mode);
+                fillSpan(cx - dx1, cx - inner, cy - dy0, mode);
+            }
+        }
+        else
+        {
+            int32_t inner = dy0 > 0 ? dy0 : 1;
+            fillColumn(cx + dx0, cy + dy0, cy + dy1, mode);
+            fillColumn(cx + dx0, cy - dy1, cy - inner, mode);
+            if(dx0 > 0)
+            {
+                fillColumn(cx - dx0, cy + dy0, cy + dy1, mode);
+                fillColumn(cx - dx0, cy - dy1, cy - inner, mode);
+            }
+        }
+    }
+
+    // Keeps the corner centres from crossing, so that opposite arcs never share a pixel.
+    static int32_t clampCornerRadius(int32_t w, int32_t h, int32_t radius)
+    {
+        int32_t limit = ((w < h ? w : h) - 1) / 2;
+        return radius < 0 ? 0 : (radius > limit ? limit : radius);
+    }
+
+    // Extends the per-page dirty column spans by the given pixel rectangle (inclusive corners, in
+    // viewport coordinates), limited to the clip rectangle.
+    void markDirty(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+    {
+        if constexpr(STRIP_MODE)
+        {
+            // Every strip is sent whole, and drawing runs once per strip.
+            return;
+        }
+        if(x0 > x1)
+        {
+            int32_t t = x0;
+            x0 = x1;
+            x1 = t;
+        }
+        if(y0 > y1)
+        {
+            int32_t t = y0;
+            y0 = y1;
+            y1 = t;
+        }
+        x0 += clipping.originX;
+        y0 += clipping.originY;
+        x1 += clipping.originX;
+        y1 += clipping.originY;
+        if(!clipColumns(x0, x1) || !clipRows(y0, y1))
+        {
+            return;
+        }
+
+        for(int32_t page = y0 >> 3; page <= (y1 >> 3); ++page)
+        {
+            if(x0 < dirtyFirstColumn[page])
+            {
+                dirtyFirstColumn[page] = x0;
+            }
+            if(x1 > dirtyLastColumn[page])
+            {
+                dirtyLastColumn[page] = x1;
+            }
+        }
+    }
+
+    void markAllDirty()
+    {
+        for(int32_t page = 0; page < PAGES; ++page)
+        {
+            dirtyFirstColumn[page] = 0;
+            dirtyLastColumn[page] = WIDTH - 1;
+        }
+    }
+
+    // Hands the back buffer over to the asynchronous transfer covering the given window and
+    // continues drawing in the other buffer. The window must be contiguous in the buffer, i.e.
+    // either a single page or full-width rows.
+    void sendWindowAndSwap(int32_t firstColumn, int32_t lastColumn, int32_t firstPage,
+                           int32_t lastPage)
+    {
+        uint8_t* frontBuffer = buffer;
+        uint8_t* backBuffer = buffer == frameBuffers[0] ? frameBuffers[1] : frameBuffers[0];
+
+        // The other buffer may still be streaming out the previous frame.
+        hwInterface.waitIdle();
+        sendWindow(firstColumn, lastColumn, firstPage, lastPage);
+
+        // Both buffers held the previous frame, so bringing the dirty spans over is enough to
+        // keep drawing incrementally on top of the frame that is being sent.
+        for(int32_t page = 0; page < PAGES; ++page)
+        {
+            if(dirtyLastColumn[page] >= dirtyFirstColumn[page])
+            {
+                int32_t offset = dirtyFirstColumn[page] + page * WIDTH;
+                memcpy(&backBuffer[offset], &frontBuffer[offset],
+                       dirtyLastColumn[page] - dirtyFirstColumn[page] + 1);
+            }
+        }
+
+        buffer = backBuffer;
+        markClean();
+    }
+
+    // Compares the dirty spans with the shadow copy of the panel RAM and sends only the bytes
+    // that really changed. A gap of unchanged bytes between two changes is resent as long as
+    // that is cheaper than opening another address window.
+    void displayChanges()
+    {
+        if(!shadowValid)
+        {
+            displayFull();
+            return;
+        }
+
+        int32_t windowFirstColumn = 0;
+        int32_t windowLastColumn = -1;
+        int32_t windowFirstPage = 0;
+        int32_t windowLastPage = -1;
+        hwInterface.beginTransaction();
+
+        // Runs covering the same columns on consecutive pages share one window.
+        auto emitRun = [&](int32_t firstColumn, int32_t lastColumn, int32_t page) {
+            if(windowLastPage == page - 1 && windowFirstColumn == firstColumn &&
+               windowLastColumn == lastColumn)
+            {
+                windowLastPage = page;
+                return;
+            }
+            if(windowLastPage >= 0)
+            {
+                sendWindow(windowFirstColumn, windowLastColumn, windowFirstPage, windowLastPage);
+            }
+            windowFirstColumn = firstColumn;
+            windowLastColumn = lastColumn;
+            windowFirstPage = page;
+            windowLastPage = page;
+        };
+
+        for(int32_t page = 0; page < PAGES; ++page)
+        {
+            int32_t first = dirtyFirstColumn[page];
+            int32_t last = dirtyLastColumn[page];
+            if(last < first)
+            {
+                continue;
+            }
+
+            const uint8_t* current = &buffer[page * WIDTH];
+            uint8_t* shown = &shadow[page * WIDTH];
+            int32_t runFirst = -1;
+            int32_t runLast = -1;
+            for(int32_t column = first; column <= last; ++column)
+            {
+                if(current[column] == shown[column])
+                {
+                    continue;
+                }
+                if(runFirst < 0)
+                {
+                    runFirst = column;
+                }
+                else if(column - runLast - 1 > windowCost)
+                {
+                    emitRun(runFirst, runLast, page);
+                    runFirst = column;
+                }
+                runLast = column;
+            }
+            if(runFirst >= 0)
+            {
+                emitRun(runFirst, runLast, page);
+            }
+
+            memcpy(&shown[first], &current[first], last - first + 1);
+        }
+
+        if(windowLastPage >= 0)
+        {
+            sendWindow(windowFirstColumn, windowLastColumn, windowFirstPage, windowLastPage);
+        }
+        hwInterface.endTransaction();
+        markClean();
+    }
+
+    void markClean()
+    {
+        for(int32_t page = 0; page < PAGES; ++page)
+        {
+            dirtyFirstColumn[page] = WIDTH;
+            dirtyLastColumn[page] = -1;
+        }
+    }
+
+    void sendWindow(int32_t firstColumn, int32_t lastColumn, int32_t firstPage, int32_t lastPage)
+    {
+        uint8_t commands[] = {SSD1306_COLUMNADDR,
+                              static_cast<uint8_t>(firstColumn),
+                              static_cast<uint8_t>(lastColumn),
+                              SSD1306_PAGEADDR,
+                              static_cast<uint8_t>(firstPage),
+                              static_cast<uint8_t>(lastPage)};
+
+        if constexpr(DOUBLE_BUFFERED)
+        {
+            hwInterface.sendCommands(commands, sizeof(commands));
+            hwInterface.sendDataBulkAsync(&buffer[firstColumn + pageRow(firstPage)],
+                                          (lastColumn - firstColumn + 1) *
+                                              (lastPage - firstPage + 1));
+            return;
+        }
+
+        if(firstColumn == 0 && lastColumn == WIDTH - 1)
+        {
+            // Full-width rows are contiguous in the buffer, so the window goes out in one burst.
+            hwInterface.sendCommandsAndData(commands, sizeof(commands),
+                                            &buffer[pageRow(firstPage)],
+                                            (lastPage - firstPage + 1) * WIDTH);
+            return;
+        }
+
+        hwInterface.beginTransaction();
+        hwInterface.sendCommands(commands, sizeof(commands));
+        for(int32_t page = firstPage; page <= lastPage; ++page)
+        {
+            hwInterface.sendDataBulk(&buffer[firstColumn + pageRow(page)],
+                                     lastColumn - firstColumn + 1);
+        }
+        hwInterface.endTransaction();
+    }
+
+  public:
+#ifndef SSD1306_HOST_BUILD
+    // Drives a panel on the default SPI block and pins (see SPIConfig). For other pins, clocks or
+    // several panels, construct an SPIInterface from an SPIConfig and pass it in instead.
+    OledDisplay() :
+        OledDisplay(*new SSD1306::SPIInterface())
+    {
+    }
+#endif
+
+    explicit OledDisplay(SSD1306::HardwareInterfaceBase& interface) :
+        hwInterface(interface)
+    {
+        static_assert(WIDTH > 0 && WIDTH % 8 == 0, "Width must be a multiple of 8");
+        static_assert(HEIGHT > 0 && HEIGHT % 8 == 0, "Height must be a multiple of 8");
+        static_assert(!(DOUBLE_BUFFERED && DIFF_UPDATES),
+                      "Double buffering and differential updates cannot be combined");
+        static_assert(STRIP_PAGES > 0 && STRIP_PAGES <= HEIGHT / 8,
+                      "A strip holds between one page and the whole frame");
+        static_assert(!STRIP_MODE || !(DOUBLE_BUFFERED || DIFF_UPDATES),
+                      "Strip rendering keeps no whole frame to double buffer or diff against");
+
+        hwInterface.initialize();
+
+        // With double buffering both buffers have to start out holding the same frame.
+        memset(frameBuffers, 0x00, sizeof(frameBuffers));
+        markAllDirty();
+
+        hwInterface.reset();
+
+        uint8_t mode = INVERTED ? SSD1306_INVERTDISPLAY : SSD1306_NORMALDISPLAY;
+
+        uint8_t segremapValue = 0x00;
+        uint8_t scanDirection = 0x00;
+        if constexpr(FLIP_DIRECTION)
+        {
+            segremapValue = SSD1306_SEGREMAP | 0x0;
+            scanDirection = SSD1306_COMSCANDEC | static_cast<uint8_t>(SCAN_DIRECTION::NORMAL);
+        }
+        else
+        {
+            segremapValue = SSD1306_SEGREMAP | 0x1;
+            scanDirection = SSD1306_COMSCANDEC | static_cast<uint8_t>(SCAN_DIRECTION::FLIPPED);
+        }
+
+        uint8_t commands[] = {SSD1306_DISPLAYOFF,
+                              SSD1306_SETDISPLAYCLOCKDIV,
+                              0x80,
+                              SSD1306_SETMULTIPLEX,
+                              static_cast<uint8_t>(HEIGHT - 1),
+                              SSD1306_SETDISPLAYOFFSET,
+                              0x00,
+                              static_cast<uint8_t>(SSD1306_SETSTARTLINE | 0x00),
+                              SSD1306_CHARGEPUMP,
+                              0x14,
+                              SSD1306_MEMORYMODE,
+                              static_cast<uint8_t>(MEMORY_ADDRESSING_MODE::HORIZONTAL),
+                              segremapValue,
+                              scanDirection,
+                              SSD1306_SETCOMPINS,
+                              0x12,
+                              SSD1306_SETCONTRAST,
+                              0x00,
+                              SSD1306_SETPRECHARGE,
+                              0xF1,
+                              SSD1306_SETVCOMDETECT,
+                              0x40,
+                              SSD1306_DISPLAYALLON_RESUME,
+                              mode,
+                              SSD1306_DISPLAYON};
+        hwInterface.sendCommands(commands, sizeof(commands));
+
+        // The panel RAM content is undefined after reset, so the first display() pushes everything.
+        markAllDirty();
+    }
+
+    // Size of the frame buffer expected by displayFrame().
+    static constexpr size_t FRAME_SIZE = BUFFER_SIZE;
+
+    // Size of the buffer returned by getBuffer(): FRAME_SIZE, or one strip of STRIP_PAGES pages.
+    static constexpr size_t STRIP_SIZE = WIDTH * STRIP_PAGES;
+
+    // Nesting limit of pushClip() and pushViewport().
+    static constexpr int32_t MAX_CLIP_DEPTH = 8;
+
+    constexpr int32_t width() const
+    {
+        return WIDTH;
+    }
+
+    constexpr int32_t height() const
+    {
+        return HEIGHT;
+    }
+
+    // Frame buffer in SSD1306 page layout: one byte per column and page, LSB at the top. In strip
+    // mode only the pages of the current strip.
+    const uint8_t* getBuffer() const
+    {
+        return buffer;
+    }
+
+    void clear()
+    {
+        memset(buffer, 0x00, STRIP_SIZE);
+        markAllDirty();
+    }
+
+    // Draws and sends the whole frame. draw(display) paints the frame from scratch on a cleared
+    // buffer; in strip mode (STRIP_PAGES below HEIGHT / 8) it is called once per strip of
+    // STRIP_PAGES pages with the clip rectangle set to that strip, and each strip goes out
+    // before the next one is drawn. draw therefore has to issue the same calls every time, and
+    // the result is the frame it would draw into a full buffer. copyRect() and scroll(), which
+    // read pixels back from other strips, are rejected in strip mode. Each call starts with the
+    // clip reset. Without strips this is clear(), draw and displayFull().
+    template<typename Draw>
+    void renderStrips(Draw draw)
+    {
+        if constexpr(!STRIP_MODE)
+        {
+            resetClip();
+            clear();
+            draw(*this);
+            displayFull();
+        }
+        else
+        {
+            for(int32_t page = 0; page < PAGES; page += STRIP_PAGES)
+            {
+                selectStrip(page);
+                clear();
+                draw(*this);
+                sendWindow(0, WIDTH - 1, page,
+                           page + STRIP_PAGES < PAGES ? page + STRIP_PAGES - 1 : PAGES - 1);
+            }
+            selectStrip(0);
+        }
+    }
+
+    // Sends only the regions touched by drawing calls since the last transfer. Pages sharing
+    // the same dirty column span are sent through a single address window. With DIFF_UPDATES
+    // the regions are further reduced to the bytes that differ from what the panel shows.
+    void display()
+    {
+        static_assert(!STRIP_MODE, "Strip rendering sends through renderStrips()");
+        if constexpr(DIFF_UPDATES)
+        {
+            displayChanges();
+            return;
+        }
+
+        if constexpr(DOUBLE_BUFFERED)
+        {
+            int32_t firstPage = PAGES;
+            int32_t lastPage = -1;
+            for(int32_t page = 0; page < PAGES; ++page)
+            {
+                if(dirtyLastColumn[page] >= dirtyFirstColumn[page])
+                {
+                    firstPage = page < firstPage ? page : firstPage;
+                    lastPage = page;
+                }
+            }
+            if(lastPage < 0)
+            {
+                return;
+            }
+
+            // A single DMA stream needs a contiguous source, which only a single page or
+            // full-width rows provide.
+            if(firstPage == lastPage)
+            {
+                sendWindowAndSwap(dirtyFirstColumn[firstPage], dirtyLastColumn[firstPage],
+                                  firstPage, lastPage);
+            }
+            else
+            {
+                sendWindowAndSwap(0, WIDTH - 1, firstPage, lastPage);
+            }
+            return;
+        }
+
+        // All windows share one transaction, so many small ones do not each pay for selecting
+        // the panel. Without any, the panel is not selected at all.
+        int32_t dirtyPages = 0;
+        for(int32_t page = 0; page < PAGES; ++page)
+        {
+            dirtyPages += dirtyLastColumn[page] >= dirtyFirstColumn[page] ? 1 : 0;
+        }
+        if(dirtyPages == 0)
+        {
+            return;
+        }
+        hwInterface.beginTransaction();
+        for(int32_t page = 0; page < PAGES; ++page)
+        {
+            if(dirtyLastColumn[page] < dirtyFirstColumn[page])
+            {
+                continue;
+            }
+
+            int32_t lastPage = page;
+            while(lastPage + 1 < PAGES &&
+                  dirtyFirstColumn[lastPage + 1] == dirtyFirstColumn[page] &&
+                  dirtyLastColumn[lastPage + 1] == dirtyLastColumn[page])
+            {
+                ++lastPage;
+            }
+
+            sendWindow(dirtyFirstColumn[page], dirtyLastColumn[page], page, lastPage);
+            page = lastPage;
+        }
+        hwInterface.endTransaction();
+        markClean();
+    }
+
+    // Sends the whole frame buffer regardless of dirty state.
+    void displayFull()
+    {
+        static_assert(!STRIP_MODE, "Strip rendering sends through renderStrips()");
+        if constexpr(DOUBLE_BUFFERED)
+        {
+            markAllDirty();
+            sendWindowAndSwap(0, WIDTH - 1, 0, PAGES - 1);
+            return;
+        }
+
+        sendWindow(0, WIDTH - 1, 0, PAGES - 1);
+        markClean();
+
+        if constexpr(DIFF_UPDATES)
+        {
+            memcpy(shadow, buffer, BUFFER_SIZE);
+            shadowValid = true;
+        }
+    }
+
+    // Sends a complete frame in the frame buffer layout from other memory, e.g. a snapshot handed
+    // to another core by FramePipeline. Neither the frame buffer nor the dirty state is touched,
+    // so this may run on one core while the other keeps drawing, as long as that core leaves the
+    // transport alone in the meantime.
+    void displayFrame(const uint8_t* frame) const
+    {
+        hwInterface.waitIdle();
+
+        uint8_t commands[] = {SSD1306_COLUMNADDR, 0, WIDTH - 1, SSD1306_PAGEADDR, 0, PAGES - 1};
+        hwInterface.sendCommandsAndData(commands, sizeof(commands), const_cast<uint8_t*>(frame),
+                                        BUFFER_SIZE);
+    }
+
+    // Cost of opening another address window with DIFF_UPDATES, in data bytes. Runs of unchanged
+    // bytes up to this length are resent rather than split into separate windows. The default
+    // is the six COLUMNADDR/PAGEADDR command bytes; transports with a high per-transfer overhead
+    // benefit from a larger value.
+    void setWindowCost(int32_t dataBytes)
+    {
+        windowCost = dataBytes;
+    }
+
+    // Shows the frame buffer starting at the given row, wrapping around at the bottom: rows
+    // line..HEIGHT-1 appear first, followed by rows 0..line-1. Scrolling a console by a text line
+    // then costs this command plus drawing and sending the newly exposed rows, which start at
+    // bufferRow(HEIGHT - lineHeight). The wrap covers all 64 rows of the panel RAM, so this needs
+    // a 64-row frame buffer.
+    void setStartLine(int32_t line)
+    {
+        static_assert(HEIGHT == 64, "Start line scrolling needs a 64-row frame buffer");
+        startLine = ((line % HEIGHT) + HEIGHT) % HEIGHT;
+        hwInterface.sendCommand(SSD1306_SETSTARTLINE | static_cast<uint8_t>(startLine));
+    }
+
+    int32_t getStartLine() const
+    {
+        return startLine;
+    }
+
+    // Frame buffer row shown at the given screen row under the current start line.
+    int32_t bufferRow(int32_t screenRow) const
+    {
+        return (screenRow + startLine) % HEIGHT;
+    }
+
+    // Vertical shift of the COM mapping (0..63) with wrap-around, e.g. to centre a panel whose
+    // glass is mounted offset. Unlike the start line it is usually set once.
+    void setDisplayOffset(uint8_t offset)
+    {
+        uint8_t commands[] = {SSD1306_SETDISPLAYOFFSET, static_cast<uint8_t>(offset & 0x3F)};
+        hwInterface.sendCommands(commands, sizeof(commands));
+    }
+
+    // Starts the continuous hardware scroll of pages firstPage..lastPage by one column every
+    // interval. With verticalOffset > 0 the rows of the vertical scroll area additionally move up
+    // by that many rows per step (diagonal scroll). The controller runs on its own until
+    // stopScroll(); frame buffer and panel RAM must not be updated in the meantime.
+    void startScroll(ScrollDirection direction, uint8_t firstPage, uint8_t lastPage,
+                     ScrollInterval interval = ScrollInterval::FRAMES_5, uint8_t verticalOffset = 0)
+    {
+        bool right = direction == ScrollDirection::RIGHT;
+        uint8_t commands[9];
+        size_t size = 0;
+        commands[size++] = SSD1306_DEACTIVATE_SCROLL;
+        if(verticalOffset == 0)
+        {
+            commands[size++] = right ? SSD1306_RIGHT_HORIZONTAL_SCROLL :
+                                       SSD1306_LEFT_HORIZONTAL_SCROLL;
+        }
+        else
+        {
+            commands[size++] = right ? SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL :
+                                       SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL;
+        }
+        commands[size++] = 0x00;
+        commands[size++] = firstPage & 0x07;
+        commands[size++] = static_cast<uint8_t>(interval);
+        commands[size++] = lastPage & 0x07;
+        if(verticalOffset == 0)
+        {
+            commands[size++] = 0x00;
+            commands[size++] = 0xFF;
+        }
+        else
+        {
+            commands[size++] = verticalOffset & 0x3F;
+        }
+        commands[size++] = SSD1306_ACTIVATE_SCROLL;
+        hwInterface.sendCommands(commands, size);
+    }
+
+    // Rows affected by the vertical part of a diagonal scroll: `fixedRows` rows at the top stay
+    // in place, the following `rows` rows scroll.
+    void setVerticalScrollArea(uint8_t fixedRows, uint8_t rows)
+    {
+        uint8_t commands[] = {SSD1306_SET_VERTICAL_SCROLL_AREA, static_cast<uint8_t>(fixedRows),
+                              rows};
+        hwInterface.sendCommands(commands, sizeof(commands));
+    }
+
+    // Stops the hardware scroll. The scroll has shifted the panel RAM, so the next display()
+    // sends the whole frame buffer again.
+    void stopScroll()
+    {
+        hwInterface.sendCommand(SSD1306_DEACTIVATE_SCROLL);
+        markAllDirty();
+        shadowValid = false;
+    }
+
+    // Blocks until the frame handed to the transport by display() has left the bus. Only needed
+    // with DOUBLE_BUFFERED before touching the panel by other means, e.g. powering it down.
+    void waitIdle()
+    {
+        hwInterface.waitIdle();
+    }
+
+    __always_inline void drawPixel(int32_t x, int32_t y, DrawMode mode = DrawMode::SET)
+    {
+        setPixel(x, y, mode);
+        markDirty(x, y, x, y);
+    }
+
+    void drawChar(int32_t x, int32_t y, char c, Fonts::FontType font = Fonts::FontType::FONT5X8,
+                  DrawMode mode = DrawMode::SET)
+    {
+        auto fontData = getFont(font);
+        drawChar(x, y, c, fontData, mode);
+    }
+
+    // Compile-time font selection: glyph size and data are constants, so the column loop can be
+    // unrolled and no virtual call is made per character.
+    template<typename Font, typename = std::enable_if_t<std::is_base_of_v<FontBase, Font>>>
+    void drawChar(int32_t x, int32_t y, char c, DrawMode mode = DrawMode::SET)
+    {
+        uint8_t index = static_cast<uint8_t>(c) - Font::CHARACTER_OFFSET;
+        if(static_cast<uint8_t>(c) < Font::CHARACTER_OFFSET || index >= Font::CHARACTER_COUNT)
+        {
+            return;
+        }
+
+        markDirty(x, y, x + Font::WIDTH - 1, y + Font::HEIGHT - 1);
+        blitColumns(x, y, &Font::DATA[index * Font::WIDTH], Font::WIDTH,
+                    0xFF >> (8 - Font::HEIGHT), mode);
+    }
+
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, DrawMode mode = DrawMode::SET)
+    {
+        markDirty(x0, y0, x1, y1);
+        strokeLine(x0, y0, x1, y1, mode, true);
+    }
+
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, DrawMode mode = DrawMode::SET)
+    {
+        if(w <= 0 || h <= 0)
+        {
+            return;
+        }
+        markDirty(x, y, x + w - 1, y + h - 1);
+        fillArea(x, y, x + w - 1, y + h - 1, mode);
+    }
+
+    // Clears the rectangle back to background without touching the rest of the frame.
+    void clearRect(int32_t x, int32_t y, int32_t w, int32_t h)
+    {
+        if(w <= 0 || h <= 0)
+        {
+            return;
+        }
+        markDirty(x, y, x + w - 1, y + h - 1);
+        fillArea(x, y, x + w - 1, y + h - 1, DrawMode::CLEAR);
+    }
+
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, DrawMode mode = DrawMode::SET)
+    {
+        if(w <= 0)
+        {
+            return;
+        }
+        markDirty(x, y, x + w - 1, y);
+        fillSpan(x, x + w - 1, y, mode);
+    }
+
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, DrawMode mode = DrawMode::SET)
+    {
+        if(h <= 0)
+        {
+            return;
+        }
+        markDirty(x, y, x, y + h - 1);
+        fillColumn(x, y, y + h - 1, mode);
+    }
+
+    // Fills the pixels whose centres lie inside the triangle. Pixels exactly on an edge follow
+    // the top-left rule, so triangles sharing an edge never overlap or leave gaps between them.
+    // Zero-area triangles are drawn as the segment they collapse to, to keep them visible.
+    void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                      DrawMode mode = DrawMode::SET)
+    {
+        auto swap = [](int32_t& a, int32_t& b) {
+            int32_t t = a;
+            a = b;
+            b = t;
+        };
+
+        if(y0 > y1)
+        {
+            swap(y0, y1);
+            swap(x0, x1);
+        }
+
+        if(y1 > y2)
+        {
+            swap(y1, y2);
+            swap(x1, x2);
+        }
+
+        if(y0 > y1)
+        {
+            swap(y0, y1);
+            swap(x0, x1);
+        }
+
+        int32_t minX = x0 < x1 ? (x0 < x2 ? x0 : x2) : (x1 < x2 ? x1 : x2);
+        int32_t maxX = x0 > x1 ? (x0 > x2 ? x0 : x2) : (x1 > x2 ? x1 : x2);
+        int64_t area = static_cast<int64_t>(x1 - x0) * (y2 - y0) -
+                       static_cast<int64_t>(x2 - x0) * (y1 - y0);
+        if(area == 0)
+        {
+            // The vertices are sorted by row, so apart from a horizontal triangle the first and
+            // last one are the ends of the segment and the middle one lies on it.
+            if(y0 == y2)
+            {
+                drawLine(minX, y0, maxX, y0, mode);
+            }
+            else
+            {
+                drawLine(x0, y0, x2, y2, mode);
+            }
+            return;
+        }
+
+        markDirty(minX, y0, maxX, y2);
+
+        int32_t clipTop = clipping.y0 - clipping.originY;
+        int32_t clipBottom = clipping.y1 - clipping.originY + 1;
+        int32_t firstRow = y0 < clipTop ? clipTop : y0;
+        int32_t lastRow = y2 > clipBottom ? clipBottom : y2;
+
+        // A positive area puts the middle vertex right of the long edge 0-2.
+        bool longEdgeLeft = area > 0;
+        TriangleEdge longEdge(x0, y0, x2, y2, firstRow);
+        TriangleEdge shortEdge(x0, y0, x1, y1, firstRow);
+        if(firstRow >= y1)
+        {
+            shortEdge = TriangleEdge(x1, y1, x2, y2, firstRow);
+        }
+
+        for(int32_t y = firstRow; y < lastRow; ++y)
+        {
+            if(y == y1)
+            {
+                shortEdge = TriangleEdge(x1, y1, x2, y2, y);
+            }
+
+            const TriangleEdge& left = longEdgeLeft ? longEdge : shortEdge;
+            const TriangleEdge& right = longEdgeLeft ? shortEdge : longEdge;
+            fillSpan(left.x, right.x - 1, y, mode);
+
+            longEdge.step();
+            shortEdge.step();
+        }
+    }
+
+    // Each edge stops short of the next vertex, so the vertices are drawn once. The edges of a row
+    // are merged into spans before drawing, so pixels that edges share near an acute corner are
+    // drawn once too and XOR does not cancel them.
+    void drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                      DrawMode mode = DrawMode::SET)
+    {
+        int32_t minX = x0 < x1 ? (x0 < x2 ? x0 : x2) : (x1 < x2 ? x1 : x2);
+        int32_t maxX = x0 > x1 ? (x0 > x2 ? x0 : x2) : (x1 > x2 ? x1 : x2);
+        int32_t minY = y0 < y1 ? (y0 < y2 ? y0 : y2) : (y1 < y2 ? y1 : y2);
+        int32_t maxY = y0 > y1 ? (y0 > y2 ? y0 : y2) : (y1 > y2 ? y1 : y2);
+        markDirty(minX, minY, maxX, maxY);
+
+        int32_t firstRow = clipping.y0 - clipping.originY;
+        int32_t lastRow = clipping.y1 - clipping.originY;
+        firstRow = minY > firstRow ? minY : firstRow;
+        lastRow = maxY < lastRow ? maxY : lastRow;
+        for(int32_t y = firstRow; y <= lastRow; ++y)
+        {
+            int32_t first[3];
+            int32_t last[3];
+            int32_t runs = 0;
+            if(edgeRun(x0, y0, x1, y1, y, first[runs], last[runs]))
+            {
+                ++runs;
+            }
+            if(edgeRun(x1, y1, x2, y2, y, first[runs], last[runs]))
+            {
+                ++runs;
+            }
+            if(edgeRun(x2, y2, x0, y0, y, first[runs], last[runs]))
+            {
+                ++runs;
+            }
+
+            // Sort the runs by their first column, then draw each group of overlapping ones once.
+            for(int32_t i = 1; i < runs; ++i)
+            {
+                for(int32_t j = i; j > 0 && first[j] < first[j - 1]; --j)
+                {
+                    int32_t swapFirst = first[j];
+                    int32_t swapLast = last[j];
+                    first[j] = first[j - 1];
+                    last[j] = last[j - 1];
+                    first[j - 1] = swapFirst;
+                    last[j - 1] = swapLast;
+                }
+            }
+            for(int32_t i = 0; i < runs;)
+            {
+                int32_t spanLast = last[i];
+                int32_t next = i + 1;
+                for(; next < runs && first[next] <= spanLast; ++next)
+                {
+                    spanLast = last[next] > spanLast ? last[next] : spanLast;
+                }
+                fillSpan(first[i], spanLast, y, mode);
+                i = next;
+            }
+        }
+    }
+
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, DrawMode mode = DrawMode::SET)
+    {
+        if(w <= 0 || h <= 0)
+        {
+            return;
+        }
+        markDirty(x, y, x + w - 1, y + h - 1);
+        fillSpan(x, x + w - 1, y, mode);
+        if(h > 1)
+        {
+            fillSpan(x, x + w - 1, y + h - 1, mode);
+        }
+        fillColumn(x, y + 1, y + h - 2, mode);
+        if(w > 1)
+        {
+            fillColumn(x + w - 1, y + 1, y + h - 2, mode);
+        }
+    }
+
+    void drawCircle(int32_t x0, int32_t y0, int32_t radius, DrawMode mode = DrawMode::SET)
+    {
+        if(radius < 0)
+        {
+            return;
+        }
+        markDirty(x0 - radius, y0 - radius, x0 + radius, y0 + radius);
+        strokeArcs(x0, y0, x0, y0, radius, mode);
+    }
+
+    // Fills the circle drawn by drawCircle() with the same radius.
+    void fillCircle(int32_t x0, int32_t y0, int32_t radius, DrawMode mode = DrawMode::SET)
+    {
+        if(radius < 0)
+        {
+            return;
+        }
+        markDirty(x0 - radius, y0 - radius, x0 + radius, y0 + radius);
+        fillArcs(x0, y0, x0, y0, radius, mode);
+    }
+
+    // Outline of an axis-aligned ellipse with the horizontal and vertical radii rx and ry. Runs
+    // of outline pixels in one row or column are written as single spans.
+    void drawEllipse(int32_t x0, int32_t y0, int32_t rx, int32_t ry,
+                     DrawMode mode = DrawMode::SET)
+    {
+        if(rx < 0 || ry < 0)
+        {
+            return;
+        }
+        markDirty(x0 - rx, y0 - ry, x0 + rx, y0 + ry);
+
+        // Current run from (startX, startY) to (endX, endY), extended while the walk stays in
+        // one row or one column.
+        int32_t startX = rx;
+        int32_t startY = 0;
+        int32_t endX = rx;
+        int32_t endY = 0;
+        bool horizontal = false;
+        bool vertical = false;
+        walkEllipse(rx, ry, [&](int32_t dx, int32_t dy) {
+            if(dx == endX && dy == endY)
+            {
+                return;
+            }
+            if(!vertical && dy == endY && dx == endX - 1)
+            {
+                horizontal = true;
+            }
+            else if(!horizontal && dx == endX && dy == endY + 1)
+            {
+                vertical = true;
+            }
+            else
+            {
+                mirrorRun(x0, y0, endX, startY, startX, endY, mode);
+                startX = dx;
+                startY = dy;
+                horizontal = false;
+                vertical = false;
+            }
+            endX = dx;
+            endY = dy;
+        });
+        mirrorRun(x0, y0, endX, startY, startX, endY, mode);
+    }
+
+    // Fills the ellipse drawn by drawEllipse() with the same radii, one vertical span per column.
+    void fillEllipse(int32_t x0, int32_t y0, int32_t rx, int32_t ry,
+                     DrawMode mode = DrawMode::SET)
+    {
+        if(rx < 0 || ry < 0)
+        {
+            return;
+        }
+        markDirty(x0 - rx, y0 - ry, x0 + rx, y0 + ry);
+
+        // The walk reaches the furthest row of a column last.
+        int32_t column = rx;
+        int32_t reach = 0;
+        walkEllipse(rx, ry, [&](int32_t dx, int32_t dy) {
+            if(dx != column)
+            {
+                fillColumn(x0 + column, y0 - reach, y0 + reach, mode);
+                fillColumn(x0 - column, y0 - reach, y0 + reach, mode);
+                column = dx;
+            }
+            reach = dy;
+        });
+        fillArea(x0 - column, y0 - reach, x0 + column, y0 + reach, mode);
+    }
+
+    // Rectangle with quarter-circle corners of the given radius, limited to (side - 1) / 2 of
+    // the shorter side.
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t radius,
+                       DrawMode mode = DrawMode::SET)
+    {
+        if(w <= 0 || h <= 0)
+        {
+            return;
+        }
+        radius = clampCornerRadius(w, h, radius);
+        markDirty(x, y, x + w - 1, y + h - 1);
+
+        int32_t left = x + radius;
+        int32_t right = x + w - 1 - radius;
+        int32_t top = y + radius;
+        int32_t bottom = y + h - 1 - radius;
+        // The arcs end on the straight edges, which only fill the gaps between them.
+        fillSpan(left + 1, right - 1, y, mode);
+        if(h > 1)
+        {
+            fillSpan(left + 1, right - 1, y + h - 1, mode);
+        }
+        fillColumn(x, top + 1, bottom - 1, mode);
+        if(w > 1)
+        {
+            fillColumn(x + w - 1, top + 1, bottom - 1, mode);
+        }
+        strokeArcs(left, top, right, bottom, radius, mode);
+    }
+
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t radius,
+                       DrawMode mode = DrawMode::SET)
+    {
+        if(w <= 0 || h <= 0)
+        {
+            return;
+        }
+        radius = clampCornerRadius(w, h, radius);
+        markDirty(x, y, x + w - 1, y + h - 1);
+        fillArcs(x + radius, y + radius, x + w - 1 - radius, y + h - 1 - radius, radius, mode);
+    }
+
+    // With COPY the text is drawn opaque: glyph cells and the spacing between characters
+    // overwrite what was there, so changing text can be redrawn in place.
+    template<typename StringType>
+    void drawText(int32_t x, int32_t y, const StringType& text,
+                  Fonts::FontType font = Fonts::FontType::FONT5X8, DrawMode mode = DrawMode::SET)
+    {
+        auto fontData = getFont(font);
+        bool follows = false;
+        for(auto c: text)
+        {
+            if(c == '\0')
+            {
+                break;
+            }
+            if(follows)
+            {
+                clearSpacing(x, y, fontData->characterSpace(), fontData->height(), mode);
+            }
+            drawChar(x, y, c, fontData, mode);
+            x += fontData->width() + fontData->characterSpace();
+            follows = true;
+        }
+    }
+
+    template<typename Font, typename StringType,
+             typename = std::enable_if_t<std::is_base_of_v<FontBase, Font>>>
+    void drawText(int32_t x, int32_t y, const StringType& text, DrawMode mode = DrawMode::SET)
+    {
+        bool follows = false;
+        for(auto c: text)
+        {
+            if(c == '\0')
+            {
+                break;
+            }
+            if(follows)
+            {
+                clearSpacing(x, y, Font::CHARACTER_SPACE, Font::HEIGHT, mode);
+            }
+            drawChar<Font>(x, y, c, mode);
+            x += Font::WIDTH + Font::CHARACTER_SPACE;
+            follows = true;
+        }
+    }
+
+    template<typename StringType>
+    void drawTextWithWrap(int32_t x, int32_t y, const StringType& text,
+                          Fonts::FontType font = Fonts::FontType::FONT5X8,
+                          DrawMode mode = DrawMode::SET)
+    {
+        auto fontData = getFont(font);
+        bool follows = false;
+        for(auto c: text)
+        {
+            if(c == '\0')
+            {
+                break;
+            }
+            if(follows)
+            {
+                clearSpacing(x, y, fontData->characterSpace(), fontData->height(), mode);
+            }
+            drawChar(x, y, c, fontData, mode);
+            x += fontData->width() + fontData->characterSpace();
+            follows = true;
+            if(x + fontData->width() > clipping.x1 + 1 - clipping.originX)
+            {
+                x = clipping.x0 - clipping.originX;
+                y += fontData->height() + 1;
+                follows = false;
+            }
+        }
+    }
+
+    template<typename Font, typename StringType,
+             typename = std::enable_if_t<std::is_base_of_v<FontBase, Font>>>
+    void drawTextWithWrap(int32_t x, int32_t y, const StringType& text,
+                          DrawMode mode = DrawMode::SET)
+    {
+        bool follows = false;
+        for(auto c: text)
+        {
+            if(c == '\0')
+            {
+                break;
+            }
+            if(follows)
+            {
+                clearSpacing(x, y, Font::CHARACTER_SPACE, Font::HEIGHT, mode);
+            }
+            drawChar<Font>(x, y, c, mode);
+            x += Font::WIDTH + Font::CHARACTER_SPACE;
+            follows = true;
+            if(x + Font::WIDTH > clipping.x1 + 1 - clipping.originX)
+            {
+                x = clipping.x0 - clipping.originX;
+                y += Font::HEIGHT + 1;
+                follows = false;
+            }
+        }
+    }
+
+    // Draws a bitmap in the SSD1306 page layout (one byte per column, LSB at the top, page rows
+    // of w bytes). Whole column bytes are copied, shifted across two pages when y is not page
+    // aligned.
+    void drawBitmap(int x, int y, const uint8_t* bitmap, int w, int h,
+                    DrawMode mode = DrawMode::SET)
+    {
+        if(w <= 0 || h <= 0)
+        {
+            return;
+        }
+        markDirty(x, y, x + w - 1, y + h - 1);
+
+        switch(mode)
+        {
+            case DrawMode::COPY:
+                blitBitmap<DrawMode::COPY>(x, y, bitmap, w, h);
+                break;
+            case DrawMode::XOR:
+                blitBitmap<DrawMode::XOR>(x, y, bitmap, w, h);
+                break;
+            case DrawMode::CLEAR:
+                blitBitmap<DrawMode::CLEAR>(x, y, bitmap, w, h);
+                break;
+            default:
+                blitBitmap<DrawMode::SET>(x, y, bitmap, w, h);
+                break;
+        }
+    }
+
+    // Decodes a run-length encoded bitmap straight into the buffer, without a temporary copy.
+    // Runs of 0x00 cost nothing (except with COPY, which clears them) and runs of 0xFF become
+    // span fills.
+    void drawBitmap(int32_t x, int32_t y, const CompressedBitmap& bitmap,
+                    DrawMode mode = DrawMode::SET)
+    {
+        int32_t width = bitmap.width;
+        int32_t height = bitmap.height;
+        if(width <= 0 || height <= 0)
+        {
+            return;
+        }
+        markDirty(x, y, x + width - 1, y + height - 1);
+
+        int32_t total = width * ((height + 7) / 8);
+        int32_t position = 0;
+        size_t index = 0;
+        while(index < bitmap.size && position < total)
+        {
+            uint8_t control = bitmap.data[index++];
+            uint8_t type = control & Rle::TYPE_MASK;
+            int32_t length = (control & Rle::LENGTH_MASK) + 1;
+
+            // A truncated stream ends the bitmap at the packet that runs past its end.
+            const uint8_t* literal = &bitmap.data[index];
+            uint8_t value = type == Rle::ONES ? 0xFF : 0x00;
+            if(type == Rle::LITERAL)
+            {
+                if(static_cast<size_t>(length) > bitmap.size - index)
+                {
+                    return;
+                }
+                index += length;
+            }
+            else if(type == Rle::REPEAT)
+            {
+                if(index >= bitmap.size)
+                {
+                    return;
+                }
+                value = bitmap.data[index++];
+            }
+
+            // A run may continue on the next page row of the bitmap.
+            while(length > 0 && position < total)
+            {
+                int32_t row = position / width;
+                int32_t column = position % width;
+                int32_t count = width - column < length ? width - column : length;
+                int32_t remainingRows = height - row * 8;
+                uint8_t mask = remainingRows >= 8 ? 0xFF : 0xFF >> (8 - remainingRows);
+
+                if(type == Rle::LITERAL)
+                {
+                    blitColumns(x + column, y + row * 8, literal, count, mask, mode);
+                    literal += count;
+                }
+                else if(value != 0x00 || mode == DrawMode::COPY)
+                {
+                    fillColumns(x + column, y + row * 8, value, count, mask, mode);
+                }
+
+                position += count;
+                length -= count;
+            }
+        }
+    }
+
+    // Draws a row-major, MSB-first bitmap (PBM/XBM layout). Each 8x8 tile is transposed into
+    // page layout on the fly and blitted as column bytes; tiles outside the display are skipped.
+    // Use convertBitmap() to transpose assets that are drawn repeatedly once up front.
+    void drawBitmapHorizontal(int x0, int y0, const uint8_t* bitmap, int width, int height,
+                              DrawMode mode = DrawMode::SET)
+    {
+        if(width <= 0 || height <= 0)
+        {
+            return;
+        }
+        markDirty(x0, y0, x0 + width - 1, y0 + height - 1);
+
+        switch(mode)
+        {
+            case DrawMode::COPY:
+                blitRowMajorBitmap<DrawMode::COPY>(x0, y0, bitmap, width, height);
+                break;
+            case DrawMode::XOR:
+                blitRowMajorBitmap<DrawMode::XOR>(x0, y0, bitmap, width, height);
+                break;
+            case DrawMode::CLEAR:
+                blitRowMajorBitmap<DrawMode::CLEAR>(x0, y0, bitmap, width, height);
+                break;
+            default:
+                blitRowMajorBitmap<DrawMode::SET>(x0, y0, bitmap, width, height);
+                break;
+        }
+    }
+
+    // Copies a w x h block of the frame buffer from srcX, srcY to dstX, dstY; the two may
+    // overlap. Only the part that lies inside the clip rectangle at both ends is copied.
+    // Page-aligned moves are plain memmoves of page rows, any other vertical move shifts whole
+    // column bytes across two source pages. Pages are visited in the direction that reads every
+    // source page before it is overwritten.
+    void copyRect(int32_t srcX, int32_t srcY, int32_t w, int32_t h, int32_t dstX, int32_t dstY)
+    {
+        static_assert(!STRIP_MODE, "copyRect() needs the whole frame buffer");
+        markDirty(dstX, dstY, dstX + w - 1, dstY + h - 1);
+
+        auto clip = [](int32_t& src, int32_t& dst, int32_t& length, int32_t first, int32_t last) {
+            int32_t low = src < dst ? src : dst;
+            if(low < first)
+            {
+                src += first - low;
+                dst += first - low;
+                length -= first - low;
+            }
+            int32_t high = src > dst ? src : dst;
+            if(high + length > last + 1)
+            {
+                length = last + 1 - high;
+            }
+        };
+        srcX += clipping.originX;
+        srcY += clipping.originY;
+        dstX += clipping.originX;
+        dstY += clipping.originY;
+        clip(srcX, dstX, w, clipping.x0, clipping.x1);
+        clip(srcY, dstY, h, clipping.y0, clipping.y1);
+        if(w <= 0 || h <= 0 || (srcX == dstX && srcY == dstY))
+        {
+            return;
+        }
+
+        int32_t shift = dstY - srcY;
+        int32_t firstPage = dstY >> 3;
+        int32_t lastPage = (dstY + h - 1) >> 3;
+        for(int32_t i = 0; i <= lastPage - firstPage; ++i)
+        {
+            int32_t page = shift > 0 ? lastPage - i : firstPage + i;
+            uint8_t mask = 0xFF;
+            if(page == firstPage)
+            {
+                mask &= 0xFF << (dstY & 7);
+            }
+            if(page == lastPage)
+            {
+                mask &= 0xFF >> (7 - ((dstY + h - 1) & 7));
+            }
+
+            // Source row that ends up in bit 0 of this page.
+            int32_t sourceRow = page * 8 - shift;
+            int32_t sourcePage = sourceRow >> 3;
+            int32_t offset = sourceRow & 7;
+            uint8_t* target = &buffer[dstX + page * WIDTH];
+            if(offset == 0 && mask == 0xFF)
+            {
+                memmove(target, &buffer[srcX + sourcePage * WIDTH], w);
+                continue;
+            }
+
+            uint8_t line[WIDTH];
+            const uint8_t* upper =
+                sourcePage >= 0 ? &buffer[srcX + sourcePage * WIDTH] : nullptr;
+            const uint8_t* lower =
+                sourcePage + 1 < PAGES ? &buffer[srcX + (sourcePage + 1) * WIDTH] : nullptr;
+            shiftColumns(line, upper, lower, w, offset);
+            for(int32_t column = 0; column < w; ++column)
+            {
+                target[column] = (target[column] & ~mask) | (line[column] & mask);
+            }
+        }
+    }
+
+    // Moves the contents of the clip rectangle (the whole frame unless one was pushed) by dx, dy
+    // pixels and clears the area that was vacated, e.g. to advance a strip chart by a column
+    // instead of replotting it.
+    void scroll(int32_t dx, int32_t dy)
+    {
+        static_assert(!STRIP_MODE, "scroll() needs the whole frame buffer");
+        int32_t left = clipping.x0 - clipping.originX;
+        int32_t top = clipping.y0 - clipping.originY;
+        int32_t right = clipping.x1 - clipping.originX;
+        int32_t bottom = clipping.y1 - clipping.originY;
+        if(left > right || top > bottom)
+        {
+            return;
+        }
+
+        copyRect(left, top, right - left + 1, bottom - top + 1, left + dx, top + dy);
+        if(dx > 0)
+        {
+            fillArea(left, top, left + dx - 1, bottom, DrawMode::CLEAR);
+        }
+        else if(dx < 0)
+        {
+            fillArea(right + dx + 1, top, right, bottom, DrawMode::CLEAR);
+        }
+        if(dy > 0)
+        {
+            fillArea(left, top, right, top + dy - 1, DrawMode::CLEAR);
+        }
+        else if(dy < 0)
+        {
+            fillArea(left, bottom + dy + 1, right, bottom, DrawMode::CLEAR);
+        }
+        markDirty(left, top, right, bottom);
+    }
+
+    // Restricts all drawing to the rectangle x, y, w, h (in the current viewport coordinates),
+    // intersected with the current clip rectangle. Every primitive clips its geometry against it
+    // once and then writes without further checks; nothing outside is drawn or marked dirty.
+    // Returns false, changing nothing, when MAX_CLIP_DEPTH entries are already pushed.
+    bool pushClip(int32_t x, int32_t y, int32_t w, int32_t h)
+    {
+        return push(x, y, w, h, false);
+    }
+
+    // Like pushClip(), and also moves the origin to x, y, so a widget can draw at 0, 0 wherever
+    // it is placed.
+    bool pushViewport(int32_t x, int32_t y, int32_t w, int32_t h)
+    {
+        return push(x, y, w, h, true);
+    }
+
+    // Restores the clip rectangle and origin in effect before the last successful push.
+    void popClip()
+    {
+        if(clipDepth > 0)
+        {
+            clipping = clipStack[--clipDepth];
+        }
+    }
+
+    // Back to the whole frame, or in strip mode to the current strip.
+    void resetClip()
+    {
+        clipDepth = 0;
+        int32_t lastRow = (stripFirstPage + STRIP_PAGES) * 8 - 1;
+        clipping = {0, stripFirstPage * 8, WIDTH - 1, lastRow < HEIGHT ? lastRow : HEIGHT - 1, 0,
+                    0};
+    }
+
+  private:
+    // Clip rectangle (inclusive, in buffer coordinates) and viewport origin.
+    struct Clipping
+    {
+        int32_t x0;
+        int32_t y0;
+        int32_t x1;
+        int32_t y1;
+        int32_t originX;
+        int32_t originY;
+    };
+
+    // Moves the strip buffer under the pages firstPage.. of the frame; pageRow() maps those pages
+    // onto it.
+    void selectStrip(int32_t firstPage)
+    {
+        stripFirstPage = firstPage;
+        resetClip();
+    }
+
+    bool push(int32_t x, int32_t y, int32_t w, int32_t h, bool moveOrigin)
+    {
+        if(clipDepth == MAX_CLIP_DEPTH)
+        {
+            return false;
+        }
+        clipStack[clipDepth++] = clipping;
+
+        x += clipping.originX;
+        y += clipping.originY;
+        int32_t x1 = x + w - 1;
+        int32_t y1 = y + h - 1;
+        clipping.x0 = x > clipping.x0 ? x : clipping.x0;
+        clipping.y0 = y > clipping.y0 ? y : clipping.y0;
+        clipping.x1 = x1 < clipping.x1 ? x1 : clipping.x1;
+        clipping.y1 = y1 < clipping.y1 ? y1 : clipping.y1;
+        if(moveOrigin)
+        {
+            clipping.originX = x;
+            clipping.originY = y;
+        }
+        return true;
+    }
+
+    SSD1306::HardwareInterfaceBase& hwInterface;
+    uint8_t frameBuffers[DOUBLE_BUFFERED ? 2 : 1][STRIP_SIZE];
+    uint8_t* buffer = frameBuffers[0];
+    int32_t stripFirstPage = 0;
+    uint8_t shadow[DIFF_UPDATES ? BUFFER_SIZE : 1];
+    bool shadowValid = false;
+    int32_t startLine = 0;
+    Clipping clipping = {0, 0, WIDTH - 1, STRIP_PAGES * 8 - 1, 0, 0};
+    Clipping clipStack[MAX_CLIP_DEPTH];
+    int32_t clipDepth = 0;
+    int32_t windowCost = 6;
+    int16_t dirtyFirstColumn[PAGES];
+    int16_t dirtyLastColumn[PAGES];
+};
+
+// OledDisplay that draws through renderStrips() into a buffer of STRIP_PAGES pages, e.g. 128
+// bytes instead of 1 KiB for a 128x64 panel with one page per strip.
+template<int32_t WIDTH, int32_t HEIGHT, int32_t STRIP_PAGES = 1, bool FLIP_DIRECTION = false,
+         bool INVERTED = false>
+using StripDisplay =
+    OledDisplay<WIDTH, HEIGHT, FLIP_DIRECTION, INVERTED, false, false, STRIP_PAGES>;
 } // namespace SSD1306
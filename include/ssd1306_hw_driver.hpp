@@ -4,106 +4,266 @@
 #include <pico/types.h>
 #include <hardware/gpio.h>
 #include <hardware/spi.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+
+#include "ssd1306_hw_interface.hpp"
+#include "ssd1306_three_wire.hpp"
 
 namespace SSD1306
 {
-class HardwareInterfaceBase
+// SPI block, pins and clock of one panel. The defaults are the board's default SPI pins with DC
+// on GPIO 20 and RST on GPIO 21. The SSD1306 datasheet rates the serial clock at 10 MHz (100 ns
+// cycle); many panels run reliably faster, but that is outside the specification.
+struct SPIConfig
 {
-  public:
-    HardwareInterfaceBase() = default;
-    ~HardwareInterfaceBase() = default;
-
-    virtual void initialize() = 0;
-    virtual void sendCommand(uint8_t command) const = 0;
-    virtual void sendCommands(uint8_t* commands, size_t size) const = 0;
-    virtual void sendData(uint8_t data) const = 0;
-    virtual void sendDataBulk(uint8_t* data, size_t size) const = 0;
-    virtual void reset() const = 0;
+    static constexpr uint32_t RATED_BAUDRATE = 10'000'000;
+
+    spi_inst_t* spi = spi_default;
+    uint32_t baudrate = RATED_BAUDRATE;
+    int32_t csPin = PICO_DEFAULT_SPI_CSN_PIN;
+    int32_t clkPin = PICO_DEFAULT_SPI_SCK_PIN;
+    int32_t sdiPin = PICO_DEFAULT_SPI_TX_PIN;
+    int32_t sdoPin = PICO_DEFAULT_SPI_RX_PIN; // -1 if not connected, the panel never answers
+    int32_t dcPin = 20; // Unused by ThreeWireSPIInterface
+    int32_t rstPin = 21;
 };
 
+// CS is asserted once per call, or once for all calls between beginTransaction() and
+// endTransaction(). DC is only switched when the kind of bytes changes, and neither waits for
+// anything but the SPI shifter to drain.
 class SPIInterface : public HardwareInterfaceBase
 {
   public:
+    // Bus usage since initialize() or resetStatistics(). Only blocking transfers are timed.
+    struct Statistics
+    {
+        uint32_t transactions = 0; // CS assertions
+        uint32_t dcChanges = 0;
+        uint64_t bytes = 0;
+        uint64_t selectedUs = 0; // Time CS was held asserted by timed transactions
+        uint64_t timedBytes = 0; // Bytes sent within those transactions
+    };
+
+    explicit SPIInterface(const SPIConfig& config = SPIConfig()) : config(config)
+    {
+    }
+
     void initialize() override;
 
+    // Clock actually set by spi_init(), the closest the peripheral divider gets to the requested
+    // baudrate. Zero before initialize().
+    inline uint32_t baudrate() const
+    {
+        return actualBaudrate;
+    }
+
     inline void sendCommand(uint8_t command) const
     {
-        commandTransfer();
-        spiWrite(&command);
+        write(false, &command, 1);
     }
 
     inline void sendCommands(uint8_t* commands, size_t size) const
     {
-        commandTransfer();
-        spiBulkWrite(commands, size);
+        write(false, commands, size);
     }
 
     inline void sendData(uint8_t data) const
     {
-        dataTransfer();
-        spiWrite(&data);
+        write(true, &data, 1);
     }
 
     inline void sendDataBulk(uint8_t* data, size_t size) const
     {
-        dataTransfer();
-        spiBulkWrite(data, size);
+        write(true, data, size);
+    }
+
+    inline void beginTransaction() const override
+    {
+        if(transactionDepth++ == 0)
+        {
+            waitIdle();
+            transactionStart = time_us_32();
+            csSelect();
+        }
+    }
+
+    inline void endTransaction() const override
+    {
+        if(--transactionDepth == 0)
+        {
+            csDeselect();
+            stats.selectedUs += time_us_32() - transactionStart;
+            stats.transactions += 1;
+        }
+    }
+
+    // Streams the data through a DMA channel paced by the SPI TX DREQ. CS is released from the
+    // DMA interrupt once the SPI shifter has drained, DC is left in data mode.
+    void sendDataBulkAsync(uint8_t* data, size_t size) const override;
+
+    inline bool isBusy() const override
+    {
+        return transferBusy;
+    }
+
+    inline void waitIdle() const override
+    {
+        while(transferBusy)
+        {
+            tight_loop_contents();
+        }
+    }
+
+    const Statistics& statistics() const
+    {
+        return stats;
+    }
+
+    void resetStatistics()
+    {
+        stats = Statistics();
+    }
+
+    // Time CS was held during timed transactions without bits moving: the selected time minus
+    // what the bytes take at baudrate(). This is the fixed cost each transaction adds.
+    uint64_t idleUs() const
+    {
+        uint64_t shiftingUs =
+            actualBaudrate != 0 ? stats.timedBytes * 8 * 1'000'000 / actualBaudrate : 0;
+        return stats.selectedUs > shiftingUs ? stats.selectedUs - shiftingUs : 0;
     }
 
     inline void reset() const
     {
-        gpio_put(RST_PIN, 0);
+        gpio_put(config.rstPin, 0);
         sleep_ms(10);
-        gpio_put(RST_PIN, 1);
+        gpio_put(config.rstPin, 1);
         sleep_ms(10);
     }
 
   private:
-    static constexpr int32_t CS_PIN = PICO_DEFAULT_SPI_CSN_PIN;
-    static constexpr int32_t CLK_PIN = PICO_DEFAULT_SPI_SCK_PIN;
-    static constexpr int32_t SDI_PIN = PICO_DEFAULT_SPI_TX_PIN;
-    static constexpr int32_t SDO_PIN = PICO_DEFAULT_SPI_RX_PIN;
-    static constexpr int32_t DC_PIN = 20;
-    static constexpr int32_t RST_PIN = 21;
+    const SPIConfig config;
+    uint32_t actualBaudrate = 0;
 
+    static void dmaIrqHandler();
+    void finishTransfer() const;
+
+    static SPIInterface* dmaChannelOwners[NUM_DMA_CHANNELS];
+    int32_t dmaChannel = -1;
+    mutable volatile bool transferBusy = false;
+    mutable bool dataMode = false;
+    mutable int32_t transactionDepth = 0;
+    mutable uint32_t transactionStart = 0;
+    mutable Statistics stats;
+
+    // The SSD1306 needs 20 ns of CS setup and 10 ns of hold time. Writing the SPI FIFO and the
+    // shifter's first half clock cycle take longer than that, and the last clock edge has passed
+    // once spi_write_blocking() or the drain in finishTransfer() returns.
     inline void csSelect() const
     {
-        asm volatile("nop \n nop \n nop \n nop");
-        gpio_put(CS_PIN, 0); // Active low
-        asm volatile("nop \n nop \n nop \n nop");
+        gpio_put(config.csPin, 0); // Active low
     }
 
     inline void csDeselect() const
     {
-        asm volatile("nop \n nop \n nop \n nop");
-        gpio_put(CS_PIN, 1);
-        asm volatile("nop \n nop \n nop \n nop");
+        gpio_put(config.csPin, 1);
     }
 
-    inline void spiWrite(uint8_t* data) const
+    // DC is sampled with the last bit of each byte. spi_write_blocking() returns once the shifter
+    // has drained, so it can switch right away.
+    inline void setDataMode(bool data) const
     {
-        csSelect();
-        spi_write_blocking(spi_default, data, 1);
-        csDeselect();
+        if(data != dataMode)
+        {
+            gpio_put(config.dcPin, data);
+            dataMode = data;
+            stats.dcChanges += 1;
+        }
     }
 
-    inline void dataTransfer() const
+    inline void write(bool data, uint8_t* bytes, size_t size) const
     {
-        gpio_put(DC_PIN, 1);
-        sleep_us(1);
+        beginTransaction();
+        setDataMode(data);
+        spi_write_blocking(config.spi, bytes, size);
+        stats.bytes += size;
+        stats.timedBytes += size;
+        endTransaction();
     }
+};
 
-    inline void commandTransfer() const
+// Drives a panel strapped for 3-wire SPI (BS0..BS2 = 1, 0, 0), which needs no DC pin. The SPI
+// block runs in 9-bit mode and every byte goes out as a frame carrying the DC bit (see
+// ThreeWire), so a command prefix and its data are one uninterrupted stream. Frames are encoded
+// into two small chunks and fed to the SPI by DMA, one chunk being encoded while the other is
+// sent. Transfers are blocking: sendDataBulkAsync() falls back to sendDataBulk().
+class ThreeWireSPIInterface : public HardwareInterfaceBase
+{
+  public:
+    explicit ThreeWireSPIInterface(const SPIConfig& config = SPIConfig()) : config(config)
     {
-        gpio_put(DC_PIN, 0);
-        sleep_us(1);
     }
 
-    inline void spiBulkWrite(uint8_t* data, size_t size) const
+    void initialize() override;
+
+    inline uint32_t baudrate() const
     {
-        csSelect();
-        spi_write_blocking(spi_default, data, size);
-        csDeselect();
+        return actualBaudrate;
     }
+
+    inline void sendCommand(uint8_t command) const override
+    {
+        write(false, &command, 1);
+    }
+
+    inline void sendCommands(uint8_t* commands, size_t size) const override
+    {
+        write(false, commands, size);
+    }
+
+    inline void sendData(uint8_t data) const override
+    {
+        write(true, &data, 1);
+    }
+
+    inline void sendDataBulk(uint8_t* data, size_t size) const override
+    {
+        write(true, data, size);
+    }
+
+    // Everything sent inside the bracket is queued into the same frame stream under one CS
+    // assertion; the stream only pauses when the encoder has to wait for a chunk to drain.
+    void beginTransaction() const override;
+    void endTransaction() const override;
+
+    inline void reset() const override
+    {
+        gpio_put(config.rstPin, 0);
+        sleep_ms(10);
+        gpio_put(config.rstPin, 1);
+        sleep_ms(10);
+    }
+
+  private:
+    // 256 frames, 512 bytes in two chunks.
+    static constexpr size_t CHUNK_FRAMES = 128;
+
+    const SPIConfig config;
+    uint32_t actualBaudrate = 0;
+    int32_t dmaChannel = -1;
+
+    mutable ThreeWire::FrameEncoder<CHUNK_FRAMES> encoder;
+    mutable int32_t transactionDepth = 0;
+
+    inline void write(bool data, uint8_t* bytes, size_t size) const
+    {
+        beginTransaction();
+        encoder.append(bytes, size, data,
+                       [this](const uint16_t* frames, size_t count) { startChunk(frames, count); });
+        endTransaction();
+    }
+
+    void startChunk(const uint16_t* frames, size_t count) const;
 };
-} // namespace SSD1306
\ No newline at end of file
+} // namespace SSD1306
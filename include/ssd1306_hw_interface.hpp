@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <stddef.h>
+
+namespace SSD1306
+{
+class HardwareInterfaceBase
+{
+  public:
+    HardwareInterfaceBase() = default;
+    ~HardwareInterfaceBase() = default;
+
+    virtual void initialize() = 0;
+    virtual void sendCommand(uint8_t command) const = 0;
+    virtual void sendCommands(uint8_t* commands, size_t size) const = 0;
+    virtual void sendData(uint8_t data) const = 0;
+    virtual void sendDataBulk(uint8_t* data, size_t size) const = 0;
+    virtual void reset() const = 0;
+
+    // Brackets calls that belong to one transaction, e.g. an address window and the pages that
+    // fill it, so that transports with a per-transfer cost select the panel only once. Brackets
+    // may nest. Nothing else may use the transport in between, and sendDataBulkAsync() is not
+    // allowed inside.
+    virtual void beginTransaction() const
+    {
+    }
+
+    virtual void endTransaction() const
+    {
+    }
+
+    // A command prefix followed by its data payload as one transaction.
+    void sendCommandsAndData(uint8_t* commands, size_t commandSize, uint8_t* data,
+                             size_t dataSize) const
+    {
+        beginTransaction();
+        sendCommands(commands, commandSize);
+        if(dataSize > 0)
+        {
+            sendDataBulk(data, dataSize);
+        }
+        endTransaction();
+    }
+
+    // Called once an asynchronous transfer has completed. On the target this runs in interrupt
+    // context, so the callback must be short and must not start another transfer itself.
+    using TransferCompleteCallback = void (*)(void* context);
+
+    // Starts sending data without waiting for it to leave the bus; the buffer has to stay valid
+    // and unmodified until waitIdle() returns. Interfaces without an asynchronous transport fall
+    // back to a blocking transfer.
+    virtual void sendDataBulkAsync(uint8_t* data, size_t size) const
+    {
+        sendDataBulk(data, size);
+        if(transferCompleteCallback != nullptr)
+        {
+            transferCompleteCallback(transferCompleteContext);
+        }
+    }
+
+    virtual bool isBusy() const
+    {
+        return false;
+    }
+
+    virtual void waitIdle() const
+    {
+    }
+
+    void setTransferCompleteCallback(TransferCompleteCallback callback, void* context = nullptr)
+    {
+        transferCompleteCallback = callback;
+        transferCompleteContext = context;
+    }
+
+  protected:
+    TransferCompleteCallback transferCompleteCallback = nullptr;
+    void* transferCompleteContext = nullptr;
+};
+} // namespace SSD1306
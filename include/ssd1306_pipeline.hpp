@@ -0,0 +1,217 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stddef.h>
+
+namespace SSD1306
+{
+// What happens to a frame submitted while the transfer side is still behind.
+enum class FramePolicy
+{
+    WAIT,        // submit() blocks until a slot is free, every frame is sent in order
+    DROP_NEWEST, // submit() drops the new frame when all slots are taken
+    LATEST_WINS  // submit() never blocks, the transfer side always sends the newest frame
+};
+
+// Single-producer single-consumer handoff of whole frames between two cores (or threads). The
+// producer copies finished frames into a slot, the consumer sends them out of the slot. Only
+// atomic loads and stores are used, no read-modify-write operations, so it stays lock-free on
+// the Cortex-M0+ of the RP2040, which has no exclusive access instructions.
+//
+// WAIT and DROP_NEWEST use a ring of SLOTS frames. LATEST_WINS uses three slots as a triple
+// buffer: the consumer announces the slot it is about to read and confirms that it is still the
+// newest one, the producer writes into the slot that is neither the newest nor announced.
+template<size_t FRAME_SIZE, FramePolicy POLICY = FramePolicy::LATEST_WINS, size_t SLOTS = 3>
+class FrameQueue
+{
+    static_assert(POLICY != FramePolicy::LATEST_WINS || SLOTS == 3,
+                  "LATEST_WINS works on exactly three slots");
+    static_assert(SLOTS >= 2, "At least two slots are needed");
+
+  public:
+    // Producer side. Copies the frame into a free slot and publishes it. Returns false if the
+    // frame was dropped.
+    bool push(const uint8_t* frame)
+    {
+        uint32_t sequence = increment(submitted);
+
+        if constexpr(POLICY == FramePolicy::LATEST_WINS)
+        {
+            uint32_t newest = slotOf(latest.load());
+            uint32_t announced = reading.load();
+            uint32_t slot = 0;
+            while(slot == newest || slot == announced)
+            {
+                ++slot;
+            }
+
+            memcpy(frames[slot], frame, FRAME_SIZE);
+            // The sequence wraps after 2^24 submits. A frame published then can compare equal to
+            // current, the last one the consumer took, and is skipped as already sent.
+            latest.store((sequence << 8) | slot);
+            return true;
+        }
+        else
+        {
+            uint32_t h = head.load(std::memory_order_relaxed);
+            while(distance(h, tail.load(std::memory_order_acquire)) == SLOTS)
+            {
+                if constexpr(POLICY == FramePolicy::DROP_NEWEST)
+                {
+                    increment(dropped);
+                    return false;
+                }
+            }
+
+            memcpy(frames[h % SLOTS], frame, FRAME_SIZE);
+            head.store((h + 1) % (2 * SLOTS), std::memory_order_release);
+            return true;
+        }
+    }
+
+    // Consumer side. Returns the next frame to send, or nullptr if there is none. The frame stays
+    // valid until pop().
+    const uint8_t* front()
+    {
+        if constexpr(POLICY == FramePolicy::LATEST_WINS)
+        {
+            uint32_t newest = latest.load();
+            while(newest != NONE && newest != current)
+            {
+                reading.store(slotOf(newest));
+                uint32_t confirmed = latest.load();
+                if(confirmed == newest)
+                {
+                    current = newest;
+                    return frames[slotOf(newest)];
+                }
+                newest = confirmed;
+            }
+            return nullptr;
+        }
+        else
+        {
+            uint32_t t = tail.load(std::memory_order_relaxed);
+            if(t == head.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+            return frames[t % SLOTS];
+        }
+    }
+
+    // Consumer side. Marks the frame returned by front() as sent.
+    void pop()
+    {
+        increment(sent);
+        if constexpr(POLICY != FramePolicy::LATEST_WINS)
+        {
+            uint32_t t = tail.load(std::memory_order_relaxed);
+            tail.store((t + 1) % (2 * SLOTS), std::memory_order_release);
+        }
+    }
+
+    // With LATEST_WINS nothing is dropped on submit; the frames that were superseded before they
+    // could be sent are the difference between submitted and sent.
+    uint32_t framesSubmitted() const
+    {
+        return submitted.load(std::memory_order_relaxed);
+    }
+
+    uint32_t framesDropped() const
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    uint32_t framesSent() const
+    {
+        return sent.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    static constexpr uint32_t slotOf(uint32_t published)
+    {
+        return published == NONE ? NONE : published & 0xFF;
+    }
+
+    // Ring positions run over twice the slot count, so a full ring differs from an empty one.
+    static constexpr uint32_t distance(uint32_t from, uint32_t to)
+    {
+        return (from + 2 * SLOTS - to) % (2 * SLOTS);
+    }
+
+    uint8_t frames[SLOTS][FRAME_SIZE];
+
+    // Ring indices, head written by the producer only, tail by the consumer only.
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+
+    // Triple buffer: newest published frame as (sequence << 8) | slot, written by the producer,
+    // and the slot the consumer reads, written by the consumer.
+    std::atomic<uint32_t> latest{NONE};
+    std::atomic<uint32_t> reading{NONE};
+    uint32_t current = NONE;
+
+    // Each counter has a single writer, so a plain load and store is enough to count.
+    static uint32_t increment(std::atomic<uint32_t>& counter)
+    {
+        uint32_t value = counter.load(std::memory_order_relaxed) + 1;
+        counter.store(value, std::memory_order_relaxed);
+        return value;
+    }
+
+    std::atomic<uint32_t> submitted{0};
+    std::atomic<uint32_t> dropped{0};
+    std::atomic<uint32_t> sent{0};
+};
+
+// Renders on one core and transfers on the other: the render core draws as usual and calls
+// submit() instead of display(), which snapshots the frame buffer into the queue. The transfer
+// core calls transferNext() in a loop (on the Pico e.g. from a multicore_launch_core1() entry),
+// sending every frame whole through displayFrame(). The render core must not use display() or
+// the transport while the pipeline runs.
+template<typename Display, FramePolicy POLICY = FramePolicy::LATEST_WINS, size_t SLOTS = 3>
+class FramePipeline
+{
+    static_assert(Display::STRIP_SIZE == Display::FRAME_SIZE,
+                  "Strip rendering keeps no whole frame to hand over");
+
+  public:
+    explicit FramePipeline(Display& display) :
+        display(display)
+    {
+    }
+
+    // Render core. Returns false if the frame was dropped.
+    bool submit()
+    {
+        return queue.push(display.getBuffer());
+    }
+
+    // Transfer core. Sends the next frame if there is one and returns whether it did.
+    bool transferNext()
+    {
+        const uint8_t* frame = queue.front();
+        if(frame == nullptr)
+        {
+            return false;
+        }
+        display.displayFrame(frame);
+        queue.pop();
+        return true;
+    }
+
+    const FrameQueue<Display::FRAME_SIZE, POLICY, SLOTS>& frames() const
+    {
+        return queue;
+    }
+
+  private:
+    Display& display;
+    FrameQueue<Display::FRAME_SIZE, POLICY, SLOTS> queue;
+};
+} // namespace SSD1306
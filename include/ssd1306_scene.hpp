@@ -0,0 +1,415 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stddef.h>
+
+#include "compressed_bitmap.hpp"
+#include "fonts.hpp"
+
+namespace SSD1306
+{
+// Retained-mode layer on top of OledDisplay: the screen is described by a list of elements that
+// stay in place between frames. Changing an element only records the area it covered before and
+// covers now; render() clears those areas and redraws the elements that overlap them, clipped to
+// each area, so static chrome is neither redrawn nor resent.
+//
+// The scene owns the whole display: anything drawn directly into the frame buffer is wiped where
+// the scene gets damaged. Handles stay valid until the element is removed, after which the slot
+// may be handed out again. Elements are drawn in the order they were added.
+template<typename Display, int32_t CAPACITY = 32, size_t TEXT_SIZE = 24>
+class Scene
+{
+  public:
+    using Handle = int32_t;
+    static constexpr Handle INVALID_HANDLE = -1;
+
+    explicit Scene(Display& display) :
+        display(display)
+    {
+        damage(0, 0, display.width() - 1, display.height() - 1);
+    }
+
+    Handle addText(int32_t x, int32_t y, const char* text,
+                   Fonts::FontType font = Fonts::FontType::FONT5X8)
+    {
+        Element element = {};
+        element.type = Type::TEXT;
+        element.x = x;
+        element.y = y;
+        element.font = font;
+        copyText(element, text);
+        return add(element);
+    }
+
+    Handle addRect(int32_t x, int32_t y, int32_t w, int32_t h, bool filled = false)
+    {
+        Element element = {};
+        element.type = filled ? Type::FILLED_RECT : Type::RECT;
+        element.x = x;
+        element.y = y;
+        element.w = w;
+        element.h = h;
+        return add(element);
+    }
+
+    Handle addLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+    {
+        Element element = {};
+        element.type = Type::LINE;
+        element.x = x0;
+        element.y = y0;
+        element.w = x1;
+        element.h = y1;
+        return add(element);
+    }
+
+    Handle addCircle(int32_t x, int32_t y, int32_t radius)
+    {
+        Element element = {};
+        element.type = Type::CIRCLE;
+        element.x = x;
+        element.y = y;
+        element.w = radius;
+        return add(element);
+    }
+
+    // Bitmap in the page layout of drawBitmap(); the data has to outlive the element.
+    Handle addBitmap(int32_t x, int32_t y, const uint8_t* bitmap, int32_t w, int32_t h)
+    {
+        Element element = {};
+        element.type = Type::BITMAP;
+        element.x = x;
+        element.y = y;
+        element.w = w;
+        element.h = h;
+        element.bitmap = bitmap;
+        return add(element);
+    }
+
+    Handle addBitmap(int32_t x, int32_t y, const CompressedBitmap& bitmap)
+    {
+        Element element = {};
+        element.type = Type::COMPRESSED_BITMAP;
+        element.x = x;
+        element.y = y;
+        element.w = bitmap.width;
+        element.h = bitmap.height;
+        element.compressed = &bitmap;
+        return add(element);
+    }
+
+    void remove(Handle handle)
+    {
+        if(!isValid(handle))
+        {
+            return;
+        }
+        damage(elements[handle]);
+        elements[handle].type = Type::NONE;
+
+        int32_t position = 0;
+        while(order[position] != handle)
+        {
+            ++position;
+        }
+        memmove(&order[position], &order[position + 1], (count - position - 1) * sizeof(Handle));
+        --count;
+    }
+
+    // Replaces the text of a text element; does nothing if the text is unchanged.
+    void setText(Handle handle, const char* text)
+    {
+        if(!isValid(handle) || strncmp(elements[handle].text, text, TEXT_SIZE - 1) == 0)
+        {
+            return;
+        }
+        damage(elements[handle]);
+        copyText(elements[handle], text);
+        damage(elements[handle]);
+    }
+
+    // Moves the element so that its anchor (top-left corner, line start or circle centre) ends
+    // up at x, y.
+    void moveTo(Handle handle, int32_t x, int32_t y)
+    {
+        if(!isValid(handle) || (elements[handle].x == x && elements[handle].y == y))
+        {
+            return;
+        }
+        Element& element = elements[handle];
+        damage(element);
+        if(element.type == Type::LINE)
+        {
+            element.w += x - element.x;
+            element.h += y - element.y;
+        }
+        element.x = x;
+        element.y = y;
+        damage(element);
+    }
+
+    // Changes the size of a rectangle or bitmap, the end point of a line or the radius of a
+    // circle (w).
+    void resize(Handle handle, int32_t w, int32_t h = 0)
+    {
+        if(!isValid(handle) || (elements[handle].w == w && elements[handle].h == h))
+        {
+            return;
+        }
+        damage(elements[handle]);
+        elements[handle].w = w;
+        elements[handle].h = h;
+        damage(elements[handle]);
+    }
+
+    // Swaps the data of a bitmap element, e.g. to the next animation frame of the same size.
+    void setBitmap(Handle handle, const uint8_t* bitmap)
+    {
+        if(!isValid(handle) || elements[handle].bitmap == bitmap)
+        {
+            return;
+        }
+        elements[handle].bitmap = bitmap;
+        damage(elements[handle]);
+    }
+
+    void setVisible(Handle handle, bool visible)
+    {
+        if(!isValid(handle) || elements[handle].visible == visible)
+        {
+            return;
+        }
+        Rect bounds = boundsOf(elements[handle]);
+        elements[handle].visible = visible;
+        damage(bounds.x0, bounds.y0, bounds.x1, bounds.y1);
+    }
+
+    // Re-rasterizes the damaged areas into the frame buffer and marks only them dirty, so the
+    // following display() sends just what changed.
+    void render()
+    {
+        for(int32_t i = 0; i < damageCount; ++i)
+        {
+            const Rect& area = damaged[i];
+            int32_t w = area.x1 - area.x0 + 1;
+            int32_t h = area.y1 - area.y0 + 1;
+            bool clipped = display.pushClip(area.x0, area.y0, w, h);
+            display.clearRect(area.x0, area.y0, w, h);
+
+            for(int32_t j = 0; j < count; ++j)
+            {
+                const Element& element = elements[order[j]];
+                if(element.visible && intersects(boundsOf(element), area))
+                {
+                    draw(element);
+                }
+            }
+            if(clipped)
+            {
+                display.popClip();
+            }
+        }
+        damageCount = 0;
+    }
+
+    // Redraws every element, e.g. after the frame buffer was modified behind the scene's back.
+    void invalidate()
+    {
+        damage(0, 0, display.width() - 1, display.height() - 1);
+    }
+
+  private:
+    enum class Type : uint8_t
+    {
+        NONE,
+        TEXT,
+        RECT,
+        FILLED_RECT,
+        LINE,
+        CIRCLE,
+        BITMAP,
+        COMPRESSED_BITMAP
+    };
+
+    // Inclusive corners.
+    struct Rect
+    {
+        int32_t x0;
+        int32_t y0;
+        int32_t x1;
+        int32_t y1;
+    };
+
+    // w and h double as the line end point and the circle radius.
+    struct Element
+    {
+        Type type;
+        bool visible;
+        Fonts::FontType font;
+        int32_t x;
+        int32_t y;
+        int32_t w;
+        int32_t h;
+        const uint8_t* bitmap;
+        const CompressedBitmap* compressed;
+        char text[TEXT_SIZE];
+    };
+
+    static constexpr int32_t MAX_DAMAGE = 8;
+
+    bool isValid(Handle handle) const
+    {
+        return handle >= 0 && handle < CAPACITY && elements[handle].type != Type::NONE;
+    }
+
+    Handle add(Element& element)
+    {
+        Handle handle = 0;
+        while(handle < CAPACITY && elements[handle].type != Type::NONE)
+        {
+            ++handle;
+        }
+        if(handle == CAPACITY)
+        {
+            return INVALID_HANDLE;
+        }
+
+        element.visible = true;
+        elements[handle] = element;
+        order[count++] = handle;
+        damage(element);
+        return handle;
+    }
+
+    static void copyText(Element& element, const char* text)
+    {
+        strncpy(element.text, text, TEXT_SIZE - 1);
+        element.text[TEXT_SIZE - 1] = '\0';
+    }
+
+    static Rect boundsOf(const Element& element)
+    {
+        switch(element.type)
+        {
+            case Type::TEXT:
+            {
+                const FontBase* font = Fonts::getFont(element.font);
+                int32_t length = static_cast<int32_t>(strlen(element.text));
+                int32_t advance = font->width() + font->characterSpace();
+                return {element.x, element.y, element.x + length * advance - 1,
+                        element.y + font->height() - 1};
+            }
+            case Type::LINE:
+                return {element.x < element.w ? element.x : element.w,
+                        element.y < element.h ? element.y : element.h,
+                        element.x < element.w ? element.w : element.x,
+                        element.y < element.h ? element.h : element.y};
+            case Type::CIRCLE:
+                return {element.x - element.w, element.y - element.w, element.x + element.w,
+                        element.y + element.w};
+            default:
+                return {element.x, element.y, element.x + element.w - 1, element.y + element.h - 1};
+        }
+    }
+
+    static bool intersects(const Rect& a, const Rect& b)
+    {
+        return a.x0 <= b.x1 && b.x0 <= a.x1 && a.y0 <= b.y1 && b.y0 <= a.y1;
+    }
+
+    static Rect unite(const Rect& a, const Rect& b)
+    {
+        return {a.x0 < b.x0 ? a.x0 : b.x0, a.y0 < b.y0 ? a.y0 : b.y0, a.x1 > b.x1 ? a.x1 : b.x1,
+                a.y1 > b.y1 ? a.y1 : b.y1};
+    }
+
+    static int32_t areaOf(const Rect& r)
+    {
+        return (r.x1 - r.x0 + 1) * (r.y1 - r.y0 + 1);
+    }
+
+    void damage(const Element& element)
+    {
+        if(element.visible)
+        {
+            Rect bounds = boundsOf(element);
+            damage(bounds.x0, bounds.y0, bounds.x1, bounds.y1);
+        }
+    }
+
+    // Records an area to redraw. Overlapping areas are merged; once the list is full the area is
+    // merged into the entry that grows the least.
+    void damage(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+    {
+        Rect area = {x0 > 0 ? x0 : 0, y0 > 0 ? y0 : 0,
+                     x1 < display.width() - 1 ? x1 : display.width() - 1,
+                     y1 < display.height() - 1 ? y1 : display.height() - 1};
+        if(area.x1 < area.x0 || area.y1 < area.y0)
+        {
+            return;
+        }
+
+        int32_t best = -1;
+        int32_t bestGrowth = 0;
+        for(int32_t i = 0; i < damageCount; ++i)
+        {
+            int32_t growth = areaOf(unite(damaged[i], area)) - areaOf(damaged[i]);
+            if(intersects(damaged[i], area) || growth <= 0)
+            {
+                best = i;
+                break;
+            }
+            if(best < 0 || growth < bestGrowth)
+            {
+                best = i;
+                bestGrowth = growth;
+            }
+        }
+
+        if(best >= 0 && (damageCount == MAX_DAMAGE || intersects(damaged[best], area)))
+        {
+            damaged[best] = unite(damaged[best], area);
+            return;
+        }
+        damaged[damageCount++] = area;
+    }
+
+    void draw(const Element& element)
+    {
+        switch(element.type)
+        {
+            case Type::TEXT:
+                display.drawText(element.x, element.y, element.text, element.font);
+                break;
+            case Type::RECT:
+                display.drawRect(element.x, element.y, element.w, element.h);
+                break;
+            case Type::FILLED_RECT:
+                display.fillRect(element.x, element.y, element.w, element.h);
+                break;
+            case Type::LINE:
+                display.drawLine(element.x, element.y, element.w, element.h);
+                break;
+            case Type::CIRCLE:
+                display.drawCircle(element.x, element.y, element.w);
+                break;
+            case Type::BITMAP:
+                display.drawBitmap(element.x, element.y, element.bitmap, element.w, element.h);
+                break;
+            case Type::COMPRESSED_BITMAP:
+                display.drawBitmap(element.x, element.y, *element.compressed);
+                break;
+            default:
+                break;
+        }
+    }
+
+    Display& display;
+    Element elements[CAPACITY] = {};
+    Handle order[CAPACITY]; // Drawing order, slots are reused after remove()
+    int32_t count = 0;
+    Rect damaged[MAX_DAMAGE];
+    int32_t damageCount = 0;
+};
+} // namespace SSD1306
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stddef.h>
+
+#include "ssd1306_hw_interface.hpp"
+
+namespace SSD1306
+{
+// Lets several panels share one SPI peripheral. Every panel keeps its own interface with its own
+// CS, DC and RST pins (e.g. SPIInterfaces whose SPIConfigs only differ in those), which is
+// attached to a port of the bus; the display is then constructed on the port. Ports queue what
+// their display sends and service() moves it on to the panels in slices of at most sliceSize
+// bytes, always taking the highest-priority port with queued data and rotating between ports of
+// equal priority. A full-frame refresh on one panel therefore does not hold back a small update
+// on another.
+//
+// Everything runs on the calling core: service() has to be called regularly, e.g. from the main
+// loop, and flush() services the bus until every queue has drained. A port whose queue is full
+// services the bus itself until there is room again.
+template<int32_t PORTS, size_t QUEUE_SIZE = 1280>
+class SharedBus
+{
+  public:
+    struct Statistics
+    {
+        uint64_t bytes;
+        uint32_t transfers;
+    };
+
+    class Port : public HardwareInterfaceBase
+    {
+      public:
+        void initialize() override
+        {
+            bus->flush();
+            target->initialize();
+        }
+
+        void sendCommand(uint8_t command) const override
+        {
+            enqueue(true, &command, 1);
+        }
+
+        void sendCommands(uint8_t* commands, size_t size) const override
+        {
+            enqueue(true, commands, size);
+        }
+
+        void sendData(uint8_t data) const override
+        {
+            enqueue(false, &data, 1);
+        }
+
+        // The data is copied into the queue, so the caller's buffer is free again on return.
+        void sendDataBulk(uint8_t* data, size_t size) const override
+        {
+            enqueue(false, data, size);
+        }
+
+        void reset() const override
+        {
+            waitIdle();
+            target->reset();
+        }
+
+        bool isBusy() const override
+        {
+            return used != 0 || bus->active == this;
+        }
+
+        void waitIdle() const override
+        {
+            while(isBusy())
+            {
+                bus->service();
+            }
+        }
+
+      private:
+        friend class SharedBus;
+
+        // Consecutive sends of the same kind are merged into one segment.
+        struct Segment
+        {
+            bool command;
+            size_t length;
+        };
+
+        static constexpr size_t SEGMENTS = 32;
+
+        void enqueue(bool command, const uint8_t* bytes, size_t size) const
+        {
+            while(size > 0)
+            {
+                bool extend = segmentCount > 0 && lastSegment().command == command;
+                while(used == QUEUE_SIZE || (!extend && segmentCount == SEGMENTS))
+                {
+                    bus->service();
+                    extend = segmentCount > 0 && lastSegment().command == command;
+                }
+
+                if(used == 0)
+                {
+                    tail = 0;
+                }
+                size_t head = (tail + used) % QUEUE_SIZE;
+                size_t chunk = head >= tail ? QUEUE_SIZE - head : tail - head;
+                chunk = chunk < size ? chunk : size;
+                memcpy(&queue[head], bytes, chunk);
+                used += chunk;
+
+                if(extend)
+                {
+                    lastSegment().length += chunk;
+                }
+                else
+                {
+                    segments[(firstSegment + segmentCount) % SEGMENTS] = {command, chunk};
+                    ++segmentCount;
+                }
+
+                bytes += chunk;
+                size -= chunk;
+            }
+        }
+
+        Segment& lastSegment() const
+        {
+            return segments[(firstSegment + segmentCount - 1) % SEGMENTS];
+        }
+
+        // Starts sending the front of the queue, limited to the front segment and to the bytes
+        // that are contiguous in the ring.
+        void startSlice(size_t sliceSize) const
+        {
+            const Segment& segment = segments[firstSegment];
+            size_t length = segment.length < sliceSize ? segment.length : sliceSize;
+            length = length < QUEUE_SIZE - tail ? length : QUEUE_SIZE - tail;
+
+            if(segment.command)
+            {
+                target->sendCommands(&queue[tail], length);
+            }
+            else
+            {
+                target->sendDataBulkAsync(&queue[tail], length);
+            }
+            inFlight = length;
+
+            stats.bytes += length;
+            stats.transfers += 1;
+        }
+
+        // Releases the slice started last once the target has finished with it.
+        void retireSlice() const
+        {
+            tail = (tail + inFlight) % QUEUE_SIZE;
+            used -= inFlight;
+
+            Segment& segment = segments[firstSegment];
+            segment.length -= inFlight;
+            if(segment.length == 0)
+            {
+                firstSegment = (firstSegment + 1) % SEGMENTS;
+                --segmentCount;
+            }
+            inFlight = 0;
+        }
+
+        SharedBus* bus = nullptr;
+        HardwareInterfaceBase* target = nullptr;
+        int32_t priority = 0;
+
+        mutable uint8_t queue[QUEUE_SIZE];
+        mutable size_t tail = 0;
+        mutable size_t used = 0;
+        mutable size_t inFlight = 0;
+
+        mutable Segment segments[SEGMENTS];
+        mutable size_t firstSegment = 0;
+        mutable size_t segmentCount = 0;
+
+        mutable Statistics stats = {};
+    };
+
+    SharedBus() = default;
+    SharedBus(const SharedBus&) = delete;
+    SharedBus& operator=(const SharedBus&) = delete;
+
+    // Binds the panel interface to a port and returns the port to construct the display on.
+    // Ports with a higher priority are always served first.
+    Port& attach(int32_t index, HardwareInterfaceBase& interface, int32_t priority = 0)
+    {
+        Port& port = ports[index];
+        port.bus = this;
+        port.target = &interface;
+        port.priority = priority;
+        return port;
+    }
+
+    const Port& port(int32_t index) const
+    {
+        return ports[index];
+    }
+
+    void setPriority(int32_t index, int32_t priority)
+    {
+        ports[index].priority = priority;
+    }
+
+    // Upper bound for a single transfer; smaller slices interleave the panels more finely at the
+    // cost of a CS/DC cycle per slice. The default is one page row of a 128 pixel wide panel.
+    void setSliceSize(size_t bytes)
+    {
+        sliceSize = bytes > 0 ? bytes : 1;
+    }
+
+    // Retires the finished transfer and starts the next slice. Returns without blocking while a
+    // transfer is still running, and returns false once there is nothing left to start.
+    bool service()
+    {
+        if(active != nullptr)
+        {
+            if(active->target->isBusy())
+            {
+                return true;
+            }
+            active->retireSlice();
+            active = nullptr;
+        }
+
+        int32_t next = -1;
+        for(int32_t i = 1; i <= PORTS; ++i)
+        {
+            int32_t index = (lastPort + i) % PORTS;
+            const Port& port = ports[index];
+            if(port.used != 0 && (next < 0 || port.priority > ports[next].priority))
+            {
+                next = index;
+            }
+        }
+        if(next < 0)
+        {
+            return false;
+        }
+
+        lastPort = next;
+        active = &ports[next];
+        active->startSlice(sliceSize);
+        return true;
+    }
+
+    void flush()
+    {
+        while(service())
+        {
+        }
+    }
+
+    bool isIdle() const
+    {
+        if(active != nullptr)
+        {
+            return false;
+        }
+        for(const Port& port : ports)
+        {
+            if(port.used != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const Statistics& statistics(int32_t index) const
+    {
+        return ports[index].stats;
+    }
+
+    void resetStatistics()
+    {
+        for(Port& port : ports)
+        {
+            port.stats = {};
+        }
+    }
+
+  private:
+    Port ports[PORTS];
+    const Port* active = nullptr;
+    int32_t lastPort = PORTS - 1;
+    size_t sliceSize = 128;
+};
+} // namespace SSD1306
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <stddef.h>
+#include <vector>
+
+#include "ssd1306_hw_interface.hpp"
+
+namespace SSD1306
+{
+// Hardware interface that interprets the SSD1306 command stream into an emulated controller
+// instead of driving a bus. Used by the host build to check rendering and transfer behaviour
+// without a panel on the bench.
+class SimulatedSSD1306 : public HardwareInterfaceBase
+{
+  public:
+    static constexpr int32_t RAM_COLUMNS = 128;
+    static constexpr int32_t RAM_PAGES = 8;
+    static constexpr int32_t RAM_ROWS = RAM_PAGES * 8;
+
+    struct Statistics
+    {
+        size_t commandBytes = 0;
+        size_t dataBytes = 0;
+        size_t commandTransfers = 0;
+        size_t dataTransfers = 0;
+        size_t transactions = 0; // Panel selections: single calls and bracketed transactions
+        size_t dcChanges = 0;
+    };
+
+    // What one transaction carried: command and data bytes, and how often DC switched between
+    // the two within it.
+    struct Transaction
+    {
+        size_t commandBytes;
+        size_t dataBytes;
+        size_t dcChanges;
+    };
+
+    SimulatedSSD1306(int32_t width = 128, int32_t height = 64);
+
+    void initialize() override;
+    void sendCommand(uint8_t command) const override;
+    void sendCommands(uint8_t* commands, size_t size) const override;
+    void sendData(uint8_t data) const override;
+    void sendDataBulk(uint8_t* data, size_t size) const override;
+    void beginTransaction() const override;
+    void endTransaction() const override;
+
+    // Takes 9-bit frames as a panel strapped for 3-wire SPI receives them (see ThreeWire), each
+    // carrying its own DC bit, and processes them like the corresponding sendCommands() and
+    // sendDataBulk() calls.
+    void receiveFrames(const uint16_t* frames, size_t count) const;
+    void reset() const override;
+
+    // Pixel as seen on the glass, after segment/COM remapping, start line, display offset,
+    // vertical scroll, inversion and display on/off have been applied. (0, 0) is the top left
+    // corner of the panel.
+    bool pixel(int32_t x, int32_t y) const;
+
+    // Raw GDDRAM content, addressed the same way as the OledDisplay frame buffer.
+    uint8_t ramByte(int32_t column, int32_t page) const
+    {
+        return ram[page][column];
+    }
+
+    bool ramPixel(int32_t column, int32_t row) const
+    {
+        return (ram[row >> 3][column] >> (row & 7)) & 1;
+    }
+
+    // Lets the given number of display frames pass, which is what drives the continuous scroll.
+    void advanceFrames(int32_t frames = 1);
+
+    bool isScrolling() const
+    {
+        return state.scrollActive;
+    }
+
+    // Writes the visible panel content as a plain PBM (P1) image.
+    void writePbm(std::ostream& stream) const;
+
+    const Statistics& statistics() const
+    {
+        return stats;
+    }
+
+    void resetStatistics()
+    {
+        stats = Statistics();
+    }
+
+    // Keeps a log of every transaction from now on, e.g. to check how a display() call was
+    // batched. Off by default, as the log grows with every transfer.
+    void recordTransactions(bool enabled)
+    {
+        recording = enabled;
+        log.clear();
+    }
+
+    const std::vector<Transaction>& transactions() const
+    {
+        return log;
+    }
+
+    bool isInitialized() const
+    {
+        return initialized;
+    }
+
+    bool isDisplayOn() const
+    {
+        return state.displayOn;
+    }
+
+    bool isInverted() const
+    {
+        return state.inverted;
+    }
+
+    uint8_t contrast() const
+    {
+        return state.contrast;
+    }
+
+  private:
+    enum class AddressingMode : uint8_t
+    {
+        HORIZONTAL = 0x00,
+        VERTICAL = 0x01,
+        PAGE = 0x02
+    };
+
+    struct ControllerState
+    {
+        AddressingMode addressingMode = AddressingMode::PAGE;
+        uint8_t columnStart = 0;
+        uint8_t columnEnd = RAM_COLUMNS - 1;
+        uint8_t pageStart = 0;
+        uint8_t pageEnd = RAM_PAGES - 1;
+        uint8_t column = 0;
+        uint8_t page = 0;
+        uint8_t startLine = 0;
+        uint8_t displayOffset = 0;
+        uint8_t multiplex = RAM_ROWS - 1;
+        uint8_t contrast = 0x7F;
+        bool segmentRemap = false;
+        bool comScanReversed = false;
+        bool inverted = false;
+        bool entireDisplayOn = false;
+        bool displayOn = false;
+
+        // Continuous scroll as set up by 26h/27h/29h/2Ah and A3h, run by 2Fh.
+        bool scrollActive = false;
+        bool scrollLeft = false;
+        uint8_t scrollStartPage = 0;
+        uint8_t scrollEndPage = 0;
+        uint8_t scrollInterval = 0;
+        uint8_t scrollVerticalOffset = 0;
+        uint8_t verticalAreaTop = 0;
+        uint8_t verticalAreaRows = RAM_ROWS;
+    };
+
+    void processCommandByte(uint8_t byte) const;
+    void executeCommand() const;
+    void writeRam(uint8_t data) const;
+    void openTransaction() const;
+    void countTransfer(bool command, size_t size) const;
+    void scrollStep();
+
+    int32_t panelWidth;
+    int32_t panelHeight;
+    bool initialized = false;
+
+    // The interface methods are const, the emulated controller is the state behind the bus.
+    mutable uint8_t ram[RAM_PAGES][RAM_COLUMNS] = {};
+    mutable ControllerState state;
+    mutable Statistics stats;
+    mutable bool dataMode = false;
+    mutable int32_t transactionDepth = 0;
+    bool recording = false;
+    mutable std::vector<Transaction> log;
+    mutable uint8_t pendingCommand[8] = {};
+    mutable size_t pendingLength = 0;
+    mutable size_t expectedLength = 0;
+    mutable int32_t scrollFrames = 0;
+    mutable int32_t verticalScroll = 0;
+};
+} // namespace SSD1306
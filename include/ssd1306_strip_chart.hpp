@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <stddef.h>
+
+namespace SSD1306
+{
+// Rolling time-series plot in a rectangle of an OledDisplay. Samples are collected into columns
+// of a fixed ring (no heap); with more than one sample per column each column keeps the minimum
+// and maximum of its samples. Every column is drawn as one vertical span reaching over to the
+// previous column, so the trace stays connected without line drawing. render() shifts the plot
+// left with copyRect() and draws only the columns completed since the last call; the whole plot
+// is redrawn when the vertical range changes, which with autoscaling happens whenever the
+// visible extremes do.
+//
+// The chart owns its rectangle; the newest column is drawn at the right edge.
+template<typename Display, int32_t CAPACITY = 128>
+class StripChart
+{
+    static_assert(CAPACITY > 0, "A strip chart needs at least one column");
+
+  public:
+    // A rectangle without width or height is rejected: the chart keeps no area and draws nothing.
+    StripChart(Display& display, int32_t x, int32_t y, int32_t w, int32_t h) :
+        display(display),
+        x(x),
+        y(y),
+        w(w <= 0 || h <= 0 ? 0 : (w < CAPACITY ? w : CAPACITY)),
+        h(w <= 0 || h <= 0 ? 0 : h)
+    {
+    }
+
+    // Fixed vertical range, low at the bottom edge and high at the top. Disables autoscaling.
+    void setRange(int32_t low, int32_t high)
+    {
+        autoScale = false;
+        updateRange(low, high);
+    }
+
+    // Fits the vertical range to the visible columns on every render().
+    void setAutoScale()
+    {
+        autoScale = true;
+    }
+
+    // Number of samples folded into one column; pending samples of a partial column are kept.
+    void setSamplesPerColumn(int32_t samples)
+    {
+        samplesPerColumn = samples > 0 ? samples : 1;
+    }
+
+    // Folds the sample into the current column, which is completed after samplesPerColumn.
+    void push(int32_t sample)
+    {
+        if(collected == 0 || sample < current.min)
+        {
+            current.min = sample;
+        }
+        if(collected == 0 || sample > current.max)
+        {
+            current.max = sample;
+        }
+        if(++collected < samplesPerColumn)
+        {
+            return;
+        }
+
+        newest = (newest + 1) % CAPACITY;
+        columns[newest] = current;
+        count += count < CAPACITY ? 1 : 0;
+        pending += pending < w ? 1 : 0;
+        collected = 0;
+    }
+
+    // Drops every sample and blanks the plot on the next render().
+    void clear()
+    {
+        count = 0;
+        collected = 0;
+        redrawAll = true;
+    }
+
+    // Brings the plot in the frame buffer up to date and marks only what changed dirty.
+    void render()
+    {
+        if(autoScale && count > 0)
+        {
+            int32_t visible = count < w ? count : w;
+            int32_t low = columns[newest].min;
+            int32_t high = columns[newest].max;
+            for(int32_t age = 1; age < visible; ++age)
+            {
+                const Column& column = columnAt(age);
+                low = column.min < low ? column.min : low;
+                high = column.max > high ? column.max : high;
+            }
+            updateRange(low, high);
+        }
+
+        if(redrawAll || pending == w)
+        {
+            display.clearRect(x, y, w, h);
+            int32_t visible = count < w ? count : w;
+            for(int32_t age = 0; age < visible; ++age)
+            {
+                drawColumn(x + w - 1 - age, age);
+            }
+        }
+        else if(pending > 0)
+        {
+            display.copyRect(x + pending, y, w - pending, h, x, y);
+            display.clearRect(x + w - pending, y, pending, h);
+            for(int32_t age = 0; age < pending; ++age)
+            {
+                drawColumn(x + w - 1 - age, age);
+            }
+        }
+        pending = 0;
+        redrawAll = false;
+    }
+
+    int32_t low() const
+    {
+        return rangeLow;
+    }
+
+    int32_t high() const
+    {
+        return rangeHigh;
+    }
+
+  private:
+    struct Column
+    {
+        int32_t min;
+        int32_t max;
+    };
+
+    const Column& columnAt(int32_t age) const
+    {
+        return columns[(newest - age + CAPACITY) % CAPACITY];
+    }
+
+    void updateRange(int32_t low, int32_t high)
+    {
+        high = high > low ? high : low + 1;
+        if(low != rangeLow || high != rangeHigh)
+        {
+            rangeLow = low;
+            rangeHigh = high;
+            redrawAll = true;
+        }
+    }
+
+    // Display row of a value, clamped to the chart.
+    int32_t rowOf(int32_t value) const
+    {
+        value = value < rangeLow ? rangeLow : (value > rangeHigh ? rangeHigh : value);
+        int64_t offset = static_cast<int64_t>(value - rangeLow) * (h - 1) / (rangeHigh - rangeLow);
+        return y + h - 1 - static_cast<int32_t>(offset);
+    }
+
+    void drawColumn(int32_t column, int32_t age)
+    {
+        const Column& sample = columnAt(age);
+        int32_t low = sample.min;
+        int32_t high = sample.max;
+        if(age + 1 < count)
+        {
+            // Reach over to the previous column so that steps leave no gap.
+            const Column& previous = columnAt(age + 1);
+            low = previous.max < low ? previous.max : low;
+            high = previous.min > high ? previous.min : high;
+        }
+
+        int32_t top = rowOf(high);
+        display.drawFastVLine(column, top, rowOf(low) - top + 1);
+    }
+
+    Display& display;
+    const int32_t x;
+    const int32_t y;
+    const int32_t w;
+    const int32_t h;
+
+    Column columns[CAPACITY];
+    int32_t newest = 0;
+    int32_t count = 0;
+    int32_t pending = 0;
+    bool redrawAll = true;
+
+    Column current = {};
+    int32_t collected = 0;
+    int32_t samplesPerColumn = 1;
+
+    bool autoScale = true;
+    int32_t rangeLow = 0;
+    int32_t rangeHigh = 1;
+};
+} // namespace SSD1306
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <stddef.h>
+
+namespace SSD1306
+{
+// 3-wire SPI has no DC line: every byte goes out as a 9-bit frame whose first bit tells commands
+// (0) from data (1). With the SPI block in 9-bit mode a frame is one 16-bit FIFO entry holding
+// the DC bit in bit 8 above the byte, so commands and data can share one DMA stream.
+namespace ThreeWire
+{
+constexpr uint16_t DATA_BIT = 0x100;
+
+constexpr uint16_t encode(uint8_t byte, bool data)
+{
+    return (data ? DATA_BIT : 0) | byte;
+}
+
+constexpr bool isData(uint16_t frame)
+{
+    return (frame & DATA_BIT) != 0;
+}
+
+constexpr uint8_t payload(uint16_t frame)
+{
+    return static_cast<uint8_t>(frame);
+}
+
+// Encodes bytes into two alternating chunks of CHUNK frames. A full chunk is handed to
+// flush(frames, count), which starts sending it and returns; the next chunk is filled while it
+// is on the way. That is the chunk handed over before, so flush has to make sure it has been
+// read before returning. finish() hands over what is left.
+template<size_t CHUNK = 128>
+class FrameEncoder
+{
+  public:
+    template<typename Flush>
+    void append(const uint8_t* bytes, size_t size, bool data, Flush flush)
+    {
+        while(size > 0)
+        {
+            uint16_t* frames = &chunks[current][used];
+            size_t count = CHUNK - used < size ? CHUNK - used : size;
+            for(size_t i = 0; i < count; ++i)
+            {
+                frames[i] = encode(bytes[i], data);
+            }
+            used += count;
+            bytes += count;
+            size -= count;
+
+            if(used == CHUNK)
+            {
+                handOver(flush);
+            }
+        }
+    }
+
+    template<typename Flush>
+    void finish(Flush flush)
+    {
+        if(used > 0)
+        {
+            handOver(flush);
+        }
+    }
+
+  private:
+    template<typename Flush>
+    void handOver(Flush flush)
+    {
+        flush(chunks[current], used);
+        current ^= 1;
+        used = 0;
+    }
+
+    uint16_t chunks[2][CHUNK];
+    int32_t current = 0;
+    size_t used = 0;
+};
+} // namespace ThreeWire
+} // namespace SSD1306
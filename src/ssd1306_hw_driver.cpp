@@ -2,23 +2,165 @@
 
 namespace SSD1306
 {
+SPIInterface* SPIInterface::dmaChannelOwners[NUM_DMA_CHANNELS] = {};
+
 void SPIInterface::initialize()
 {
-    gpio_init(CS_PIN);
-    gpio_set_dir(CS_PIN, GPIO_OUT);
+    gpio_init(config.csPin);
+    gpio_set_dir(config.csPin, GPIO_OUT);
     csDeselect();
 
-    constexpr int32_t SPI_BAUDRATE = 10'000'000;
-    spi_init(spi_default, SPI_BAUDRATE);
+    actualBaudrate = spi_init(config.spi, config.baudrate);
+
+    gpio_set_function(config.clkPin, GPIO_FUNC_SPI);
+    gpio_set_function(config.sdiPin, GPIO_FUNC_SPI);
+    if(config.sdoPin >= 0)
+    {
+        gpio_set_function(config.sdoPin, GPIO_FUNC_SPI);
+    }
+
+    gpio_init(config.dcPin);
+    gpio_set_dir(config.dcPin, GPIO_OUT);
+    gpio_put(config.dcPin, 0);
+    dataMode = false;
+
+    gpio_init(config.rstPin);
+    gpio_set_dir(config.rstPin, GPIO_OUT);
+
+    dmaChannel = dma_claim_unused_channel(true);
+    dma_channel_config dmaConfig = dma_channel_get_default_config(dmaChannel);
+    channel_config_set_transfer_data_size(&dmaConfig, DMA_SIZE_8);
+    channel_config_set_dreq(&dmaConfig, spi_get_dreq(config.spi, true));
+    channel_config_set_read_increment(&dmaConfig, true);
+    channel_config_set_write_increment(&dmaConfig, false);
+    dma_channel_configure(dmaChannel, &dmaConfig, &spi_get_hw(config.spi)->dr, nullptr, 0, false);
 
-    gpio_set_function(CLK_PIN, GPIO_FUNC_SPI);
-    gpio_set_function(SDI_PIN, GPIO_FUNC_SPI);
-    gpio_set_function(SDO_PIN, GPIO_FUNC_SPI);
+    static bool irqHandlerInstalled = false;
+    if(!irqHandlerInstalled)
+    {
+        irq_add_shared_handler(DMA_IRQ_0, dmaIrqHandler,
+                               PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        irqHandlerInstalled = true;
+    }
+    dmaChannelOwners[dmaChannel] = this;
+    dma_channel_set_irq0_enabled(dmaChannel, true);
+}
+
+void SPIInterface::sendDataBulkAsync(uint8_t* data, size_t size) const
+{
+    waitIdle();
+    setDataMode(true);
+    transferBusy = true;
+    stats.transactions += 1;
+    stats.bytes += size;
+    csSelect();
+    dma_channel_transfer_from_buffer_now(dmaChannel, data, size);
+}
 
-    gpio_init(DC_PIN);
-    gpio_set_dir(DC_PIN, GPIO_OUT);
+void SPIInterface::finishTransfer() const
+{
+    // DMA completion only means the last byte entered the TX FIFO, CS has to stay asserted until
+    // it has been shifted out.
+    while(spi_is_busy(config.spi))
+    {
+        tight_loop_contents();
+    }
+    csDeselect();
+
+    // Nothing reads the RX side during DMA transfers, drop what was received and clear overrun.
+    while(spi_is_readable(config.spi))
+    {
+        (void)spi_get_hw(config.spi)->dr;
+    }
+    spi_get_hw(config.spi)->icr = SPI_SSPICR_RORIC_BITS;
+
+    transferBusy = false;
+    if(transferCompleteCallback != nullptr)
+    {
+        transferCompleteCallback(transferCompleteContext);
+    }
+}
+
+void SPIInterface::dmaIrqHandler()
+{
+    for(uint32_t channel = 0; channel < NUM_DMA_CHANNELS; ++channel)
+    {
+        SPIInterface* owner = dmaChannelOwners[channel];
+        if(owner != nullptr && dma_channel_get_irq0_status(channel))
+        {
+            dma_channel_acknowledge_irq0(channel);
+            owner->finishTransfer();
+        }
+    }
+}
 
-    gpio_init(RST_PIN);
-    gpio_set_dir(RST_PIN, GPIO_OUT);
+void ThreeWireSPIInterface::initialize()
+{
+    gpio_init(config.csPin);
+    gpio_set_dir(config.csPin, GPIO_OUT);
+    gpio_put(config.csPin, 1);
+
+    actualBaudrate = spi_init(config.spi, config.baudrate);
+    // DC bit first, then D7..D0, sampled on the rising edge.
+    spi_set_format(config.spi, 9, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+
+    gpio_set_function(config.clkPin, GPIO_FUNC_SPI);
+    gpio_set_function(config.sdiPin, GPIO_FUNC_SPI);
+    if(config.sdoPin >= 0)
+    {
+        gpio_set_function(config.sdoPin, GPIO_FUNC_SPI);
+    }
+
+    gpio_init(config.rstPin);
+    gpio_set_dir(config.rstPin, GPIO_OUT);
+
+    // With frames wider than 8 bits every FIFO entry is a halfword.
+    dmaChannel = dma_claim_unused_channel(true);
+    dma_channel_config dmaConfig = dma_channel_get_default_config(dmaChannel);
+    channel_config_set_transfer_data_size(&dmaConfig, DMA_SIZE_16);
+    channel_config_set_dreq(&dmaConfig, spi_get_dreq(config.spi, true));
+    channel_config_set_read_increment(&dmaConfig, true);
+    channel_config_set_write_increment(&dmaConfig, false);
+    dma_channel_configure(dmaChannel, &dmaConfig, &spi_get_hw(config.spi)->dr, nullptr, 0, false);
+}
+
+void ThreeWireSPIInterface::beginTransaction() const
+{
+    if(transactionDepth++ == 0)
+    {
+        gpio_put(config.csPin, 0);
+    }
+}
+
+void ThreeWireSPIInterface::endTransaction() const
+{
+    if(--transactionDepth > 0)
+    {
+        return;
+    }
+
+    encoder.finish([this](const uint16_t* frames, size_t count) { startChunk(frames, count); });
+    dma_channel_wait_for_finish_blocking(dmaChannel);
+    // The last frames are still in the FIFO and the shifter when the DMA is done.
+    while(spi_is_busy(config.spi))
+    {
+        tight_loop_contents();
+    }
+    gpio_put(config.csPin, 1);
+
+    // Nothing reads the RX side, drop what was received and clear overrun.
+    while(spi_is_readable(config.spi))
+    {
+        (void)spi_get_hw(config.spi)->dr;
+    }
+    spi_get_hw(config.spi)->icr = SPI_SSPICR_RORIC_BITS;
+}
+
+void ThreeWireSPIInterface::startChunk(const uint16_t* frames, size_t count) const
+{
+    // The previous chunk has to be in the FIFO before the one after it is encoded into its place.
+    dma_channel_wait_for_finish_blocking(dmaChannel);
+    dma_channel_transfer_from_buffer_now(dmaChannel, frames, count);
 }
-} // namespace SSD1306
\ No newline at end of file
+} // namespace SSD1306
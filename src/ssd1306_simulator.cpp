@@ -0,0 +1,402 @@
+#include "ssd1306_simulator.hpp"
+
+#include <cstring>
+
+#include "ssd1306_three_wire.hpp"
+
+namespace SSD1306
+{
+namespace
+{
+// Number of bytes including the opcode, every command missing here is a single byte.
+size_t commandLength(uint8_t opcode)
+{
+    switch(opcode)
+    {
+        case 0x20: // Memory addressing mode
+        case 0x81: // Contrast
+        case 0x8D: // Charge pump
+        case 0xA8: // Multiplex ratio
+        case 0xD3: // Display offset
+        case 0xD5: // Clock divide
+        case 0xD9: // Pre-charge period
+        case 0xDA: // COM pins configuration
+        case 0xDB: // VCOMH deselect level
+            return 2;
+        case 0x21: // Column address
+        case 0x22: // Page address
+        case 0xA3: // Vertical scroll area
+            return 3;
+        case 0x29: // Vertical and right horizontal scroll
+        case 0x2A: // Vertical and left horizontal scroll
+            return 6;
+        case 0x26: // Right horizontal scroll
+        case 0x27: // Left horizontal scroll
+            return 7;
+        default:
+            return 1;
+    }
+}
+} // namespace
+
+SimulatedSSD1306::SimulatedSSD1306(int32_t width, int32_t height) :
+    panelWidth(width),
+    panelHeight(height)
+{
+}
+
+void SimulatedSSD1306::initialize()
+{
+    initialized = true;
+}
+
+void SimulatedSSD1306::sendCommand(uint8_t command) const
+{
+    countTransfer(true, 1);
+    processCommandByte(command);
+}
+
+void SimulatedSSD1306::sendCommands(uint8_t* commands, size_t size) const
+{
+    countTransfer(true, size);
+    for(size_t i = 0; i < size; ++i)
+    {
+        processCommandByte(commands[i]);
+    }
+}
+
+void SimulatedSSD1306::sendData(uint8_t data) const
+{
+    countTransfer(false, 1);
+    writeRam(data);
+}
+
+void SimulatedSSD1306::sendDataBulk(uint8_t* data, size_t size) const
+{
+    countTransfer(false, size);
+    for(size_t i = 0; i < size; ++i)
+    {
+        writeRam(data[i]);
+    }
+}
+
+void SimulatedSSD1306::receiveFrames(const uint16_t* frames, size_t count) const
+{
+    beginTransaction();
+    size_t first = 0;
+    while(first < count)
+    {
+        bool data = ThreeWire::isData(frames[first]);
+        size_t last = first + 1;
+        while(last < count && ThreeWire::isData(frames[last]) == data)
+        {
+            ++last;
+        }
+
+        countTransfer(!data, last - first);
+        for(size_t i = first; i < last; ++i)
+        {
+            if(data)
+            {
+                writeRam(ThreeWire::payload(frames[i]));
+            }
+            else
+            {
+                processCommandByte(ThreeWire::payload(frames[i]));
+            }
+        }
+        first = last;
+    }
+    endTransaction();
+}
+
+void SimulatedSSD1306::beginTransaction() const
+{
+    if(transactionDepth++ == 0)
+    {
+        openTransaction();
+    }
+}
+
+void SimulatedSSD1306::endTransaction() const
+{
+    --transactionDepth;
+}
+
+void SimulatedSSD1306::openTransaction() const
+{
+    stats.transactions += 1;
+    if(recording)
+    {
+        log.push_back({0, 0, 0});
+    }
+}
+
+void SimulatedSSD1306::countTransfer(bool command, size_t size) const
+{
+    if(transactionDepth == 0)
+    {
+        openTransaction();
+    }
+    if(size == 0)
+    {
+        return;
+    }
+
+    // Selecting the panel does not change DC, only a different kind of bytes does.
+    bool dcChange = dataMode == command;
+    dataMode = !command;
+    stats.dcChanges += dcChange ? 1 : 0;
+    if(command)
+    {
+        stats.commandBytes += size;
+        stats.commandTransfers += 1;
+    }
+    else
+    {
+        stats.dataBytes += size;
+        stats.dataTransfers += 1;
+    }
+    if(recording && !log.empty())
+    {
+        Transaction& transaction = log.back();
+        (command ? transaction.commandBytes : transaction.dataBytes) += size;
+        transaction.dcChanges += dcChange ? 1 : 0;
+    }
+}
+
+void SimulatedSSD1306::reset() const
+{
+    // A hardware reset restores the register defaults, GDDRAM content is left as it was.
+    state = ControllerState();
+    verticalScroll = 0;
+    pendingLength = 0;
+    expectedLength = 0;
+}
+
+void SimulatedSSD1306::processCommandByte(uint8_t byte) const
+{
+    // Multi-byte commands may be split over several transfers, so arguments are collected here.
+    if(pendingLength == 0)
+    {
+        expectedLength = commandLength(byte);
+    }
+    pendingCommand[pendingLength++] = byte;
+
+    if(pendingLength == expectedLength)
+    {
+        executeCommand();
+        pendingLength = 0;
+    }
+}
+
+void SimulatedSSD1306::executeCommand() const
+{
+    uint8_t opcode = pendingCommand[0];
+
+    if(opcode <= 0x0F)
+    {
+        state.column = (state.column & 0xF0) | opcode;
+        return;
+    }
+    if(opcode <= 0x1F)
+    {
+        state.column = (state.column & 0x0F) | ((opcode & 0x07) << 4);
+        return;
+    }
+    if(opcode >= 0x40 && opcode <= 0x7F)
+    {
+        state.startLine = opcode & 0x3F;
+        return;
+    }
+    if(opcode >= 0xB0 && opcode <= 0xB7)
+    {
+        state.page = opcode & 0x07;
+        return;
+    }
+
+    switch(opcode)
+    {
+        case 0x20:
+            state.addressingMode = static_cast<AddressingMode>(pendingCommand[1] & 0x03);
+            break;
+        case 0x21:
+            state.columnStart = pendingCommand[1] & 0x7F;
+            state.columnEnd = pendingCommand[2] & 0x7F;
+            state.column = state.columnStart;
+            break;
+        case 0x22:
+            state.pageStart = pendingCommand[1] & 0x07;
+            state.pageEnd = pendingCommand[2] & 0x07;
+            state.page = state.pageStart;
+            break;
+        case 0x81:
+            state.contrast = pendingCommand[1];
+            break;
+        case 0xA0:
+        case 0xA1:
+            state.segmentRemap = opcode & 0x01;
+            break;
+        case 0xA4:
+        case 0xA5:
+            state.entireDisplayOn = opcode & 0x01;
+            break;
+        case 0xA6:
+        case 0xA7:
+            state.inverted = opcode & 0x01;
+            break;
+        case 0xA8:
+            state.multiplex = pendingCommand[1] & 0x3F;
+            break;
+        case 0xAE:
+        case 0xAF:
+            state.displayOn = opcode & 0x01;
+            break;
+        case 0xC0:
+        case 0xC8:
+            state.comScanReversed = opcode & 0x08;
+            break;
+        case 0xD3:
+            state.displayOffset = pendingCommand[1] & 0x3F;
+            break;
+        case 0x26:
+        case 0x27:
+        case 0x29:
+        case 0x2A:
+            state.scrollLeft = opcode == 0x27 || opcode == 0x2A;
+            state.scrollStartPage = pendingCommand[2] & 0x07;
+            state.scrollInterval = pendingCommand[3] & 0x07;
+            state.scrollEndPage = pendingCommand[4] & 0x07;
+            state.scrollVerticalOffset = opcode >= 0x29 ? pendingCommand[5] & 0x3F : 0;
+            break;
+        case 0x2E:
+            state.scrollActive = false;
+            verticalScroll = 0;
+            break;
+        case 0x2F:
+            state.scrollActive = true;
+            scrollFrames = 0;
+            break;
+        case 0xA3:
+            state.verticalAreaTop = pendingCommand[1] & 0x3F;
+            state.verticalAreaRows = pendingCommand[2] & 0x7F;
+            break;
+        default:
+            // Timing and analogue settings have no visible effect on the emulated panel.
+            break;
+    }
+}
+
+void SimulatedSSD1306::writeRam(uint8_t data) const
+{
+    ram[state.page][state.column] = data;
+
+    switch(state.addressingMode)
+    {
+        case AddressingMode::HORIZONTAL:
+            if(state.column >= state.columnEnd)
+            {
+                state.column = state.columnStart;
+                state.page = state.page >= state.pageEnd ? state.pageStart : state.page + 1;
+            }
+            else
+            {
+                state.column++;
+            }
+            break;
+        case AddressingMode::VERTICAL:
+            if(state.page >= state.pageEnd)
+            {
+                state.page = state.pageStart;
+                state.column = state.column >= state.columnEnd ? state.columnStart :
+                                                                  state.column + 1;
+            }
+            else
+            {
+                state.page++;
+            }
+            break;
+        default:
+            state.column = state.column >= state.columnEnd ? state.columnStart : state.column + 1;
+            break;
+    }
+}
+
+void SimulatedSSD1306::advanceFrames(int32_t frames)
+{
+    // Frames per scroll step, indexed by the interval register value.
+    static constexpr int32_t STEP_FRAMES[] = {5, 64, 128, 256, 3, 4, 25, 2};
+
+    for(int32_t i = 0; i < frames && state.scrollActive; ++i)
+    {
+        if(++scrollFrames >= STEP_FRAMES[state.scrollInterval])
+        {
+            scrollFrames = 0;
+            scrollStep();
+        }
+    }
+}
+
+void SimulatedSSD1306::scrollStep()
+{
+    // The horizontal part rotates the scrolled pages of GDDRAM by one column, which is why the
+    // RAM has to be rewritten after the scroll has been stopped.
+    for(int32_t page = state.scrollStartPage; page <= state.scrollEndPage; ++page)
+    {
+        uint8_t* row = ram[page];
+        if(state.scrollLeft)
+        {
+            uint8_t first = row[0];
+            memmove(&row[0], &row[1], RAM_COLUMNS - 1);
+            row[RAM_COLUMNS - 1] = first;
+        }
+        else
+        {
+            uint8_t last = row[RAM_COLUMNS - 1];
+            memmove(&row[1], &row[0], RAM_COLUMNS - 1);
+            row[0] = last;
+        }
+    }
+
+    if(state.scrollVerticalOffset != 0 && state.verticalAreaRows != 0)
+    {
+        verticalScroll = (verticalScroll + state.scrollVerticalOffset) % state.verticalAreaRows;
+    }
+}
+
+bool SimulatedSSD1306::pixel(int32_t x, int32_t y) const
+{
+    if(!state.displayOn || x < 0 || y < 0 || x >= panelWidth || y >= panelHeight)
+    {
+        return false;
+    }
+    if(state.entireDisplayOn)
+    {
+        return true;
+    }
+
+    int32_t com = state.comScanReversed ? state.multiplex - y : y;
+    if(com >= state.verticalAreaTop && com < state.verticalAreaTop + state.verticalAreaRows)
+    {
+        // The vertical part of a diagonal scroll moves the rows of the scroll area up.
+        com = state.verticalAreaTop + (com - state.verticalAreaTop + verticalScroll) %
+                                          state.verticalAreaRows;
+    }
+    int32_t row = (com + state.displayOffset + state.startLine) % RAM_ROWS;
+    int32_t column = state.segmentRemap ? RAM_COLUMNS - 1 - x : x;
+
+    return ramPixel(column, row) != state.inverted;
+}
+
+void SimulatedSSD1306::writePbm(std::ostream& stream) const
+{
+    stream << "P1\n" << panelWidth << " " << panelHeight << "\n";
+    for(int32_t y = 0; y < panelHeight; ++y)
+    {
+        for(int32_t x = 0; x < panelWidth; ++x)
+        {
+            stream << (pixel(x, y) ? '1' : '0') << (x + 1 < panelWidth ? " " : "\n");
+        }
+    }
+}
+} // namespace SSD1306
@@ -0,0 +1,150 @@
+#include "test_support.hpp"
+
+// drawBitmapHorizontal() and convertBitmap() transpose 8x8 tiles at a time. Both are compared
+// with drawing the same row-major bitmap pixel by pixel, for sizes and positions that are not
+// multiples of 8 and bitmaps hanging over any edge.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+using SSD1306::DrawMode;
+
+namespace
+{
+constexpr int32_t MAX_SIZE = 40;
+constexpr int32_t MAX_ROW_BYTES = (MAX_SIZE + 7) / 8;
+
+bool bitmapPixel(const uint8_t* bitmap, int32_t width, int32_t x, int32_t y)
+{
+    return (bitmap[y * ((width + 7) / 8) + x / 8] >> (7 - x % 8)) & 1;
+}
+
+void drawPerPixel(Display& display, int32_t x0, int32_t y0, const uint8_t* bitmap, int32_t width,
+                  int32_t height, DrawMode mode)
+{
+    for(int32_t y = 0; y < height; ++y)
+    {
+        for(int32_t x = 0; x < width; ++x)
+        {
+            bool lit = bitmapPixel(bitmap, width, x, y);
+            if(mode == DrawMode::COPY)
+            {
+                display.drawPixel(x0 + x, y0 + y, lit ? DrawMode::SET : DrawMode::CLEAR);
+            }
+            else if(lit)
+            {
+                display.drawPixel(x0 + x, y0 + y, mode);
+            }
+        }
+    }
+}
+
+const DrawMode MODES[] = {DrawMode::SET, DrawMode::COPY, DrawMode::XOR, DrawMode::CLEAR};
+} // namespace
+
+TEST_CASE(transposed_tiles_match_per_pixel_drawing)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Display reference(panel);
+    Test::Random random(12);
+    uint8_t background[Display::FRAME_SIZE];
+    uint8_t bitmap[MAX_SIZE * MAX_ROW_BYTES];
+
+    for(int32_t i = 0; i < 20000; ++i)
+    {
+        int32_t width = random.range(1, MAX_SIZE);
+        int32_t height = random.range(1, MAX_SIZE);
+        int32_t x = random.range(-MAX_SIZE, 128 + 8);
+        int32_t y = random.range(-MAX_SIZE, 64 + 8);
+        DrawMode mode = MODES[i % 4];
+        random.fill(bitmap, sizeof(bitmap));
+        random.fill(background, sizeof(background));
+
+        Test::loadFrame(display, background);
+        Test::loadFrame(reference, background);
+        display.drawBitmapHorizontal(x, y, bitmap, width, height, mode);
+        drawPerPixel(reference, x, y, bitmap, width, height, mode);
+
+        bool same = memcmp(display.getBuffer(), reference.getBuffer(), Display::FRAME_SIZE) == 0;
+        if(!CHECK(same))
+        {
+            printf("  %dx%d at %d, %d, mode %d\n", width, height, x, y, static_cast<int>(mode));
+            return;
+        }
+    }
+}
+
+TEST_CASE(converted_bitmaps_hold_the_same_pixels)
+{
+    Test::Random random(13);
+    uint8_t bitmap[MAX_SIZE * MAX_ROW_BYTES];
+    uint8_t converted[MAX_SIZE * MAX_ROW_BYTES];
+
+    for(int32_t i = 0; i < 20000; ++i)
+    {
+        int32_t width = random.range(1, MAX_SIZE);
+        int32_t height = random.range(1, MAX_SIZE);
+        random.fill(bitmap, sizeof(bitmap));
+        memset(converted, 0xA5, sizeof(converted));
+        SSD1306::convertBitmap(bitmap, width, height, converted);
+
+        // Rows below height in the last page stay empty, and nothing past the size is written.
+        int32_t pages = (height + 7) / 8;
+        for(int32_t y = 0; y < pages * 8; ++y)
+        {
+            for(int32_t x = 0; x < width; ++x)
+            {
+                bool expected = y < height && bitmapPixel(bitmap, width, x, y);
+                bool actual = (converted[(y / 8) * width + x] >> (y % 8)) & 1;
+                if(!CHECK(actual == expected))
+                {
+                    printf("  %dx%d: pixel %d, %d\n", width, height, x, y);
+                    return;
+                }
+            }
+        }
+        size_t size = SSD1306::pageBitmapSize(width, height);
+        CHECK_EQUAL(size, static_cast<size_t>(width * pages));
+        for(size_t k = size; k < sizeof(converted); ++k)
+        {
+            if(!CHECK_EQUAL(converted[k], 0xA5))
+            {
+                return;
+            }
+        }
+    }
+}
+
+TEST_CASE(converted_bitmaps_draw_like_row_major_ones)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Display reference(panel);
+    Test::Random random(14);
+    uint8_t background[Display::FRAME_SIZE];
+    uint8_t bitmap[MAX_SIZE * MAX_ROW_BYTES];
+    uint8_t converted[MAX_SIZE * MAX_ROW_BYTES];
+
+    for(int32_t i = 0; i < 5000; ++i)
+    {
+        int32_t width = random.range(1, MAX_SIZE);
+        int32_t height = random.range(1, MAX_SIZE);
+        int32_t x = random.range(-MAX_SIZE, 128 + 8);
+        int32_t y = random.range(-MAX_SIZE, 64 + 8);
+        DrawMode mode = MODES[i % 4];
+        random.fill(bitmap, sizeof(bitmap));
+        random.fill(background, sizeof(background));
+        SSD1306::convertBitmap(bitmap, width, height, converted);
+
+        Test::loadFrame(display, background);
+        Test::loadFrame(reference, background);
+        display.drawBitmap(x, y, converted, width, height, mode);
+        reference.drawBitmapHorizontal(x, y, bitmap, width, height, mode);
+
+        bool same = memcmp(display.getBuffer(), reference.getBuffer(), Display::FRAME_SIZE) == 0;
+        if(!CHECK(same))
+        {
+            printf("  %dx%d at %d, %d, mode %d\n", width, height, x, y, static_cast<int>(mode));
+            return;
+        }
+    }
+}
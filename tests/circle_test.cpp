@@ -0,0 +1,278 @@
+#include "test_support.hpp"
+
+// Circles, ellipses and rounded rectangles against textbook pixel-at-a-time rasterizers: the
+// midpoint circle, Zingl's ellipse and, for the filled shapes, every column filled between the
+// outermost outline pixels. Shapes may be much larger than the panel or lie off it.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+
+namespace
+{
+// Reference pixels on the panel, plus the topmost and bottommost one of each panel column even
+// where those lie off the panel.
+struct Pixels
+{
+    bool lit[64][128] = {};
+    int32_t top[128];
+    int32_t bottom[128];
+
+    Pixels()
+    {
+        for(int32_t x = 0; x < 128; ++x)
+        {
+            top[x] = INT32_MAX;
+            bottom[x] = INT32_MIN;
+        }
+    }
+
+    void insert(int64_t x, int64_t y)
+    {
+        if(x < 0 || x >= 128)
+        {
+            return;
+        }
+        top[x] = y < top[x] ? static_cast<int32_t>(y) : top[x];
+        bottom[x] = y > bottom[x] ? static_cast<int32_t>(y) : bottom[x];
+        if(y >= 0 && y < 64)
+        {
+            lit[y][x] = true;
+        }
+    }
+};
+
+void circleOutline(Pixels& pixels, int32_t left, int32_t top, int32_t right, int32_t bottom,
+                   int32_t radius)
+{
+    int32_t x = radius;
+    int32_t y = 0;
+    int32_t error = 0;
+    while(x >= y)
+    {
+        pixels.insert(right + x, bottom + y);
+        pixels.insert(right + y, bottom + x);
+        pixels.insert(left - y, bottom + x);
+        pixels.insert(left - x, bottom + y);
+        pixels.insert(left - x, top - y);
+        pixels.insert(left - y, top - x);
+        pixels.insert(right + y, top - x);
+        pixels.insert(right + x, top - y);
+        ++y;
+        if(error <= 0)
+        {
+            error += 2 * y + 1;
+        }
+        else
+        {
+            --x;
+            error += 2 * (y - x) + 1;
+        }
+    }
+}
+
+void ellipseOutline(Pixels& pixels, int32_t cx, int32_t cy, int32_t a, int32_t b)
+{
+    auto plot = [&](int64_t dx, int64_t dy) {
+        pixels.insert(cx + dx, cy + dy);
+        pixels.insert(cx - dx, cy + dy);
+        pixels.insert(cx + dx, cy - dy);
+        pixels.insert(cx - dx, cy - dy);
+    };
+    int64_t aa = static_cast<int64_t>(a) * a;
+    int64_t bb = static_cast<int64_t>(b) * b;
+    int64_t x = -a;
+    int64_t y = 0;
+    int64_t error = x * (2 * bb + x) + bb;
+    do
+    {
+        plot(-x, y);
+        int64_t twice = 2 * error;
+        if(twice >= (x * 2 + 1) * bb)
+        {
+            error += (++x * 2 + 1) * bb;
+        }
+        if(twice <= (y * 2 + 1) * aa)
+        {
+            error += (++y * 2 + 1) * aa;
+        }
+    } while(x <= 0);
+    while(y++ < b)
+    {
+        plot(0, y);
+    }
+}
+
+void roundRectOutline(Pixels& pixels, int32_t x, int32_t y, int32_t w, int32_t h, int32_t radius)
+{
+    int32_t limit = ((w < h ? w : h) - 1) / 2;
+    radius = radius < 0 ? 0 : (radius > limit ? limit : radius);
+    int32_t left = x + radius;
+    int32_t right = x + w - 1 - radius;
+    int32_t top = y + radius;
+    int32_t bottom = y + h - 1 - radius;
+    for(int32_t i = left; i <= right; ++i)
+    {
+        pixels.insert(i, y);
+        pixels.insert(i, y + h - 1);
+    }
+    for(int32_t j = top; j <= bottom; ++j)
+    {
+        pixels.insert(x, j);
+        pixels.insert(x + w - 1, j);
+    }
+    circleOutline(pixels, left, top, right, bottom, radius);
+}
+
+// Fills every column between its topmost and bottommost pixel, which is what a convex outline
+// encloses.
+Pixels filled(const Pixels& outline)
+{
+    Pixels pixels;
+    for(int32_t x = 0; x < 128; ++x)
+    {
+        int32_t first = outline.top[x] > 0 ? outline.top[x] : 0;
+        int32_t last = outline.bottom[x] < 63 ? outline.bottom[x] : 63;
+        for(int32_t y = first; y <= last; ++y)
+        {
+            pixels.insert(x, y);
+        }
+    }
+    return pixels;
+}
+
+bool matches(const Display& display, const Pixels& expected)
+{
+    for(int32_t y = 0; y < 64; ++y)
+    {
+        for(int32_t x = 0; x < 128; ++x)
+        {
+            if(Test::bufferPixel(display, x, y) != expected.lit[y][x])
+            {
+                printf("  pixel %d, %d differs\n", x, y);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+struct Shape
+{
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+    int32_t r;
+    int32_t r2;
+};
+
+Shape randomShape(Test::Random& random, int32_t i)
+{
+    bool big = i % 10 == 0;
+    return {random.range(-20, 148),
+            random.range(-20, 84),
+            random.range(-2, big ? 300 : 90),
+            random.range(-2, big ? 200 : 70),
+            big ? random.range(0, 400) : random.range(-2, 45),
+            big ? random.range(0, 400) : random.range(-2, 45)};
+}
+
+template<typename Draw, typename Reference>
+void compare(uint32_t seed, int32_t count, Draw draw, Reference reference)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(seed);
+    for(int32_t i = 0; i < count; ++i)
+    {
+        Shape shape = randomShape(random, i);
+        display.clear();
+        draw(display, shape);
+        Pixels expected;
+        reference(expected, shape);
+        if(!CHECK(matches(display, expected)))
+        {
+            printf("  x %d y %d w %d h %d r %d r2 %d\n", shape.x, shape.y, shape.w, shape.h,
+                   shape.r, shape.r2);
+            return;
+        }
+    }
+}
+} // namespace
+
+TEST_CASE(draw_circle_matches_midpoint_circle)
+{
+    compare(
+        20, 2000, [](Display& d, const Shape& s) { d.drawCircle(s.x, s.y, s.r); },
+        [](Pixels& p, const Shape& s) {
+            if(s.r >= 0)
+            {
+                circleOutline(p, s.x, s.y, s.x, s.y, s.r);
+            }
+        });
+}
+
+TEST_CASE(fill_circle_fills_the_outline)
+{
+    compare(
+        21, 2000, [](Display& d, const Shape& s) { d.fillCircle(s.x, s.y, s.r); },
+        [](Pixels& p, const Shape& s) {
+            if(s.r >= 0)
+            {
+                Pixels outline;
+                circleOutline(outline, s.x, s.y, s.x, s.y, s.r);
+                p = filled(outline);
+            }
+        });
+}
+
+TEST_CASE(draw_ellipse_matches_reference)
+{
+    compare(
+        22, 2000, [](Display& d, const Shape& s) { d.drawEllipse(s.x, s.y, s.r, s.r2); },
+        [](Pixels& p, const Shape& s) {
+            if(s.r >= 0 && s.r2 >= 0)
+            {
+                ellipseOutline(p, s.x, s.y, s.r, s.r2);
+            }
+        });
+}
+
+TEST_CASE(fill_ellipse_fills_the_outline)
+{
+    compare(
+        23, 2000, [](Display& d, const Shape& s) { d.fillEllipse(s.x, s.y, s.r, s.r2); },
+        [](Pixels& p, const Shape& s) {
+            if(s.r >= 0 && s.r2 >= 0)
+            {
+                Pixels outline;
+                ellipseOutline(outline, s.x, s.y, s.r, s.r2);
+                p = filled(outline);
+            }
+        });
+}
+
+TEST_CASE(draw_round_rect_matches_reference)
+{
+    compare(
+        24, 2000, [](Display& d, const Shape& s) { d.drawRoundRect(s.x, s.y, s.w, s.h, s.r); },
+        [](Pixels& p, const Shape& s) {
+            if(s.w > 0 && s.h > 0)
+            {
+                roundRectOutline(p, s.x, s.y, s.w, s.h, s.r);
+            }
+        });
+}
+
+TEST_CASE(fill_round_rect_fills_the_outline)
+{
+    compare(
+        25, 2000, [](Display& d, const Shape& s) { d.fillRoundRect(s.x, s.y, s.w, s.h, s.r); },
+        [](Pixels& p, const Shape& s) {
+            if(s.w > 0 && s.h > 0)
+            {
+                Pixels outline;
+                roundRectOutline(outline, s.x, s.y, s.w, s.h, s.r);
+                p = filled(outline);
+            }
+        });
+}
@@ -0,0 +1,296 @@
+#include <cstdlib>
+
+#include "primitives.hpp"
+
+// Every primitive drawn through a stack of clip rectangles and viewports has to leave exactly
+// the pixels an unclipped drawing would leave inside the clip, and nothing outside. The
+// unclipped drawing goes to a 256x192 frame that holds the same picture 64 pixels in, so shapes
+// reaching past the small frame are drawn in full there.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+using LargeDisplay = SSD1306::OledDisplay<256, 192>;
+using SSD1306::DrawMode;
+
+namespace
+{
+constexpr int32_t MARGIN = 64;
+
+struct Rect
+{
+    int32_t x0;
+    int32_t y0;
+    int32_t x1;
+    int32_t y1;
+
+    bool contains(int32_t x, int32_t y) const
+    {
+        return x >= x0 && x <= x1 && y >= y0 && y <= y1;
+    }
+};
+
+// Pushes a random stack of clip rectangles and viewports onto display and returns the resulting
+// clip rectangle in frame coordinates; origin receives the viewport origin.
+Rect pushRandomClips(Display& display, Test::Random& random, int32_t& originX, int32_t& originY)
+{
+    Rect clip = {0, 0, 127, 63};
+    originX = 0;
+    originY = 0;
+    for(int32_t depth = random.range(0, 3); depth > 0; --depth)
+    {
+        int32_t x = random.range(-40, 140);
+        int32_t y = random.range(-20, 70);
+        int32_t w = random.range(-5, 150);
+        int32_t h = random.range(-5, 80);
+        bool viewport = random.range(0, 1) == 1;
+        if(viewport)
+        {
+            display.pushViewport(x, y, w, h);
+        }
+        else
+        {
+            display.pushClip(x, y, w, h);
+        }
+
+        x += originX;
+        y += originY;
+        int32_t x1 = x + w - 1;
+        int32_t y1 = y + h - 1;
+        clip = {x > clip.x0 ? x : clip.x0, y > clip.y0 ? y : clip.y0, x1 < clip.x1 ? x1 : clip.x1,
+                y1 < clip.y1 ? y1 : clip.y1};
+        if(viewport)
+        {
+            originX = x;
+            originY = y;
+        }
+    }
+    return clip;
+}
+
+// Only the clipped area may have been sent: every window lies inside the clip rectangle.
+bool windowsInside(const Test::RecordingInterface& panel, const Rect& clip)
+{
+    for(const Test::RecordingInterface::Window& window: panel.windows())
+    {
+        if(window.firstColumn < clip.x0 || window.lastColumn > clip.x1 ||
+           window.firstPage * 8 + 7 < clip.y0 || window.lastPage * 8 > clip.y1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Bresenham's line between two points, clipped to the frame only when plotting.
+void referenceLine(Display& display, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+    int32_t dx = abs(x1 - x0);
+    int32_t dy = -abs(y1 - y0);
+    int32_t sx = x0 < x1 ? 1 : -1;
+    int32_t sy = y0 < y1 ? 1 : -1;
+    int32_t error = dx + dy;
+    while(true)
+    {
+        display.drawPixel(x0, y0);
+        if(x0 == x1 && y0 == y1)
+        {
+            break;
+        }
+        int32_t twice = 2 * error;
+        if(twice >= dy)
+        {
+            error += dy;
+            x0 += sx;
+        }
+        if(twice <= dx)
+        {
+            error += dx;
+            y0 += sy;
+        }
+    }
+}
+} // namespace
+
+TEST_CASE(clipped_lines_start_on_the_unclipped_line)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Display reference(panel);
+    Test::Random random(21);
+
+    for(int32_t i = 0; i < 5000; ++i)
+    {
+        int32_t range = i % 3 == 0 ? 3000 : 200;
+        int32_t x0 = random.range(-range, range);
+        int32_t y0 = random.range(-range, range);
+        int32_t x1 = i % 5 == 0 ? x0 + random.range(-3, 3) : random.range(-range, range);
+        int32_t y1 = random.range(-range, range);
+        display.clear();
+        reference.clear();
+        display.drawLine(x0, y0, x1, y1);
+        referenceLine(reference, x0, y0, x1, y1);
+        if(!CHECK(memcmp(display.getBuffer(), reference.getBuffer(), Display::FRAME_SIZE) == 0))
+        {
+            printf("  drawLine(%d, %d, %d, %d)\n", x0, y0, x1, y1);
+            return;
+        }
+    }
+}
+
+TEST_CASE(clipped_drawing_matches_unclipped_drawing)
+{
+    Test::RecordingInterface panel;
+    SSD1306::SimulatedSSD1306 largePanel;
+    Display display(panel);
+    LargeDisplay large(largePanel);
+    Test::Random random(22);
+    random.fill(Test::primitiveBitmap, sizeof(Test::primitiveBitmap));
+    uint8_t background[Display::FRAME_SIZE];
+    uint8_t largeBackground[LargeDisplay::FRAME_SIZE];
+
+    for(int32_t i = 0; i < 8000; ++i)
+    {
+        random.fill(background, sizeof(background));
+        random.fill(largeBackground, sizeof(largeBackground));
+        Test::loadFrame(display, background);
+        Test::loadFrame(large, largeBackground);
+        large.drawBitmap(MARGIN, MARGIN, background, 128, 64, DrawMode::COPY);
+        display.display();
+
+        int32_t originX;
+        int32_t originY;
+        Rect clip = pushRandomClips(display, random, originX, originY);
+        Test::Primitive args = Test::randomPrimitive(random, i % Test::PRIMITIVES, -60, 180);
+
+        Test::drawPrimitive(display, args);
+        Test::drawPrimitive(large, args, originX + MARGIN, originY + MARGIN);
+        display.resetClip();
+
+        bool same = true;
+        for(int32_t y = 0; y < 64 && same; ++y)
+        {
+            for(int32_t x = 0; x < 128 && same; ++x)
+            {
+                bool expected = clip.contains(x, y) ?
+                                    Test::bufferPixel(large, x + MARGIN, y + MARGIN) :
+                                    ((background[(y / 8) * 128 + x] >> (y & 7)) & 1);
+                same = Test::bufferPixel(display, x, y) == expected;
+            }
+        }
+
+        panel.clearLog();
+        display.display();
+        if(!CHECK(same) || !CHECK(windowsInside(panel, clip)) ||
+           !CHECK(Test::ramMatches(panel, display)))
+        {
+            printf("  primitive %d, clip %d, %d - %d, %d, origin %d, %d\n", args.kind, clip.x0,
+                   clip.y0, clip.x1, clip.y1, originX, originY);
+            return;
+        }
+    }
+}
+
+TEST_CASE(copy_and_scroll_stay_inside_the_clip)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    Test::Random random(23);
+    uint8_t background[Display::FRAME_SIZE];
+    uint8_t expected[Display::FRAME_SIZE];
+    auto pixel = [](const uint8_t* frame, int32_t x, int32_t y) {
+        return (frame[(y / 8) * 128 + x] >> (y & 7)) & 1;
+    };
+
+    for(int32_t i = 0; i < 3000; ++i)
+    {
+        random.fill(background, sizeof(background));
+        Test::loadFrame(display, background);
+        display.display();
+        memcpy(expected, background, sizeof(expected));
+
+        int32_t originX;
+        int32_t originY;
+        Rect clip = pushRandomClips(display, random, originX, originY);
+        auto set = [&](int32_t x, int32_t y, bool value) {
+            uint8_t bit = static_cast<uint8_t>(1 << (y & 7));
+            expected[(y / 8) * 128 + x] = value ? (expected[(y / 8) * 128 + x] | bit) :
+                                                  (expected[(y / 8) * 128 + x] & ~bit);
+        };
+
+        if(i % 2 == 0)
+        {
+            int32_t dx = random.range(-20, 20);
+            int32_t dy = random.range(-20, 20);
+            display.scroll(dx, dy);
+            for(int32_t y = clip.y0; y <= clip.y1; ++y)
+            {
+                for(int32_t x = clip.x0; x <= clip.x1; ++x)
+                {
+                    bool inside = clip.contains(x - dx, y - dy);
+                    set(x, y, inside && pixel(background, x - dx, y - dy));
+                }
+            }
+        }
+        else
+        {
+            int32_t srcX = random.range(-60, 180);
+            int32_t srcY = random.range(-60, 120);
+            int32_t dstX = random.range(-60, 180);
+            int32_t dstY = random.range(-60, 120);
+            int32_t w = random.range(-3, 70);
+            int32_t h = random.range(-3, 70);
+            display.copyRect(srcX, srcY, w, h, dstX, dstY);
+            for(int32_t y = 0; y < h; ++y)
+            {
+                for(int32_t x = 0; x < w; ++x)
+                {
+                    int32_t fromX = srcX + x + originX;
+                    int32_t fromY = srcY + y + originY;
+                    int32_t toX = dstX + x + originX;
+                    int32_t toY = dstY + y + originY;
+                    if(clip.contains(fromX, fromY) && clip.contains(toX, toY))
+                    {
+                        set(toX, toY, pixel(background, fromX, fromY));
+                    }
+                }
+            }
+        }
+        display.resetClip();
+
+        panel.clearLog();
+        display.display();
+        if(!CHECK(memcmp(display.getBuffer(), expected, sizeof(expected)) == 0) ||
+           !CHECK(windowsInside(panel, clip)) || !CHECK(Test::ramMatches(panel, display)))
+        {
+            printf("  step %d, clip %d, %d - %d, %d\n", i, clip.x0, clip.y0, clip.x1, clip.y1);
+            return;
+        }
+    }
+}
+
+TEST_CASE(clip_stack_nests_and_is_bounded)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+
+    for(int32_t i = 0; i < Display::MAX_CLIP_DEPTH; ++i)
+    {
+        CHECK(display.pushViewport(1, 1, 100, 50));
+    }
+    CHECK(!display.pushClip(0, 0, 10, 10));
+
+    // Eight nested viewports put the origin at 8, 8.
+    display.drawPixel(0, 0);
+    CHECK(Test::bufferPixel(display, 8, 8));
+    display.popClip();
+    display.drawPixel(0, 0);
+    CHECK(Test::bufferPixel(display, 7, 7));
+
+    // An empty clip rectangle swallows everything.
+    display.resetClip();
+    display.clear();
+    display.pushClip(10, 10, 0, 5);
+    display.fillRect(0, 0, 128, 64);
+    display.popClip();
+    uint8_t empty[Display::FRAME_SIZE] = {};
+    CHECK(memcmp(display.getBuffer(), empty, sizeof(empty)) == 0);
+}
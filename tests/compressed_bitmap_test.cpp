@@ -0,0 +1,220 @@
+#include <cstring>
+#include <vector>
+
+#include "test_support.hpp"
+
+#ifdef CONVERTED_BITMAPS
+#include "pattern_compressed.hpp"
+#include "pattern_raw.hpp"
+#include "text_compressed.hpp"
+#include "text_raw.hpp"
+#endif
+
+// A run-length encoded bitmap has to draw exactly like the page-layout bytes it decodes to, in
+// every mode, and a stream that ends early must not be read past its end.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+using SSD1306::CompressedBitmap;
+using SSD1306::DrawMode;
+namespace Rle = SSD1306::Rle;
+
+namespace
+{
+struct Encoded
+{
+    std::vector<uint8_t> stream;
+    std::vector<uint8_t> bytes;
+};
+
+// Random packets of every type covering width x height, with the page-layout bytes they decode
+// to.
+Encoded randomEncoding(Test::Random& random, int32_t width, int32_t height)
+{
+    Encoded encoded;
+    int32_t left = width * ((height + 7) / 8);
+    while(left > 0)
+    {
+        int32_t length = random.range(1, Rle::MAX_RUN);
+        length = length < left ? length : left;
+        uint8_t type = static_cast<uint8_t>(random.range(0, 3) << 6);
+        encoded.stream.push_back(static_cast<uint8_t>(type | (length - 1)));
+        uint8_t value = type == Rle::ONES ? 0xFF : type == Rle::REPEAT ? random.byte() : 0x00;
+        if(type == Rle::REPEAT)
+        {
+            encoded.stream.push_back(value);
+        }
+        for(int32_t i = 0; i < length; ++i)
+        {
+            if(type == Rle::LITERAL)
+            {
+                value = random.byte();
+                encoded.stream.push_back(value);
+            }
+            encoded.bytes.push_back(value);
+        }
+        left -= length;
+    }
+    return encoded;
+}
+
+// Draws bitmap and the raw bytes onto the same background and compares the results.
+bool drawsLikeRaw(const CompressedBitmap& bitmap, const uint8_t* raw, int32_t x, int32_t y,
+                  DrawMode mode, const uint8_t* background)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Display reference(panel);
+    Test::loadFrame(display, background);
+    Test::loadFrame(reference, background);
+    display.drawBitmap(x, y, bitmap, mode);
+    reference.drawBitmap(x, y, raw, bitmap.width, bitmap.height, mode);
+    return memcmp(display.getBuffer(), reference.getBuffer(), Display::FRAME_SIZE) == 0;
+}
+} // namespace
+
+TEST_CASE(random_streams_draw_like_their_raw_bytes)
+{
+    Test::Random random(71);
+    uint8_t background[Display::FRAME_SIZE];
+
+    for(int32_t i = 0; i < 3000; ++i)
+    {
+        int32_t width = random.range(1, 70);
+        int32_t height = random.range(1, 40);
+        Encoded encoded = randomEncoding(random, width, height);
+        CompressedBitmap bitmap = {static_cast<uint16_t>(width), static_cast<uint16_t>(height),
+                                   encoded.stream.data(), encoded.stream.size()};
+        int32_t x = random.range(-40, 130);
+        int32_t y = random.range(-30, 70);
+        DrawMode mode = static_cast<DrawMode>(random.range(0, 3));
+        random.fill(background, sizeof(background));
+        if(!CHECK(drawsLikeRaw(bitmap, encoded.bytes.data(), x, y, mode, background)))
+        {
+            printf("  %dx%d at %d, %d, mode %d\n", width, height, x, y, static_cast<int>(mode));
+            return;
+        }
+    }
+}
+
+TEST_CASE(runs_continue_on_the_next_page_row)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+
+    // One run of eight 0xFF bytes over a 5 column bitmap fills page 0 and three columns of page 1.
+    const uint8_t stream[] = {Rle::ONES | 7, Rle::ZEROS | 1};
+    display.drawBitmap(10, 0, CompressedBitmap{5, 16, stream, sizeof(stream)});
+    for(int32_t column = 0; column < 5; ++column)
+    {
+        CHECK_EQUAL(display.getBuffer()[10 + column], 0xFF);
+        CHECK_EQUAL(display.getBuffer()[128 + 10 + column], column < 3 ? 0xFF : 0x00);
+    }
+
+    // A literal split across the row boundary keeps its byte order.
+    const uint8_t literal[] = {Rle::LITERAL | 3, 0x01, 0x02, 0x03, 0x04};
+    display.clear();
+    display.drawBitmap(0, 8, CompressedBitmap{3, 16, literal, sizeof(literal)});
+    CHECK_EQUAL(display.getBuffer()[128 + 0], 0x01);
+    CHECK_EQUAL(display.getBuffer()[128 + 2], 0x03);
+    CHECK_EQUAL(display.getBuffer()[256 + 0], 0x04);
+}
+
+TEST_CASE(partial_last_page_leaves_the_rows_below_alone)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+
+    // 11 rows: the second page row only covers rows 8 to 10.
+    const uint8_t stream[] = {Rle::ONES | 3, Rle::ZEROS | 3};
+    display.fillRect(0, 0, 128, 64);
+    display.drawBitmap(0, 0, CompressedBitmap{4, 11, stream, sizeof(stream)}, DrawMode::COPY);
+    CHECK_EQUAL(display.getBuffer()[0], 0xFF);
+    CHECK_EQUAL(display.getBuffer()[128], 0xF8);
+
+    // All 11 rows lit, moved down by 3: rows 3 to 13.
+    const uint8_t ones[] = {Rle::ONES | 7};
+    display.clear();
+    display.drawBitmap(0, 3, CompressedBitmap{4, 11, ones, sizeof(ones)});
+    CHECK_EQUAL(display.getBuffer()[0], 0xF8);
+    CHECK_EQUAL(display.getBuffer()[128], 0x3F);
+    CHECK_EQUAL(display.getBuffer()[256], 0x00);
+}
+
+TEST_CASE(zero_runs_clear_with_copy_and_keep_with_xor)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    const uint8_t stream[] = {Rle::ZEROS | 7, Rle::REPEAT | 7, 0x00};
+    CompressedBitmap bitmap = {8, 16, stream, sizeof(stream)};
+
+    display.fillRect(0, 0, 128, 64);
+    display.drawBitmap(4, 4, bitmap, DrawMode::XOR);
+    CHECK(Test::bufferPixel(display, 4, 4));
+    CHECK(Test::bufferPixel(display, 11, 19));
+
+    display.drawBitmap(4, 4, bitmap, DrawMode::SET);
+    CHECK(Test::bufferPixel(display, 4, 4));
+
+    display.drawBitmap(4, 4, bitmap, DrawMode::COPY);
+    bool cleared = true;
+    for(int32_t y = 4; y < 20; ++y)
+    {
+        for(int32_t x = 4; x < 12; ++x)
+        {
+            cleared = cleared && !Test::bufferPixel(display, x, y);
+        }
+    }
+    CHECK(cleared);
+    CHECK(Test::bufferPixel(display, 3, 4));
+    CHECK(Test::bufferPixel(display, 12, 4));
+    CHECK(Test::bufferPixel(display, 4, 20));
+}
+
+TEST_CASE(truncated_streams_stop_at_their_end)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    uint8_t empty[Display::FRAME_SIZE] = {};
+
+    // The bytes after size must never be drawn: a literal that claims more bytes than are left
+    // draws nothing of them.
+    const uint8_t literal[] = {Rle::LITERAL | 9, 0x11, 0x22, 0x33, 0xFF, 0xFF, 0xFF, 0xFF,
+                               0xFF, 0xFF, 0xFF, 0xFF};
+    display.drawBitmap(0, 0, CompressedBitmap{10, 8, literal, 4});
+    CHECK(memcmp(display.getBuffer(), empty, sizeof(empty)) == 0);
+
+    // A repeat packet cut off before its value ends the bitmap after the packets before it.
+    const uint8_t repeat[] = {Rle::ZEROS | 3, Rle::ONES | 1, Rle::REPEAT | 5, 0xFF};
+    display.drawBitmap(0, 0, CompressedBitmap{10, 8, repeat, 3});
+    for(int32_t column = 0; column < 10; ++column)
+    {
+        CHECK_EQUAL(display.getBuffer()[column], column == 4 || column == 5 ? 0xFF : 0x00);
+    }
+
+    // An empty stream draws nothing.
+    display.clear();
+    display.drawBitmap(0, 0, CompressedBitmap{10, 8, repeat, 0}, DrawMode::COPY);
+    CHECK(memcmp(display.getBuffer(), empty, sizeof(empty)) == 0);
+}
+
+#ifdef CONVERTED_BITMAPS
+TEST_CASE(converter_output_draws_like_its_raw_output)
+{
+    Test::Random random(72);
+    uint8_t background[Display::FRAME_SIZE];
+    random.fill(background, sizeof(background));
+
+    CHECK_EQUAL(pattern_compressed.width, pattern_raw_width);
+    CHECK_EQUAL(pattern_compressed.height, pattern_raw_height);
+    CHECK(pattern_compressed.size < sizeof(pattern_raw));
+    CHECK(text_compressed.size < sizeof(text_raw));
+    for(DrawMode mode: {DrawMode::SET, DrawMode::CLEAR, DrawMode::XOR, DrawMode::COPY})
+    {
+        CHECK(drawsLikeRaw(pattern_compressed, pattern_raw, 0, 0, mode, background));
+        CHECK(drawsLikeRaw(pattern_compressed, pattern_raw, 95, 50, mode, background));
+        CHECK(drawsLikeRaw(pattern_compressed, pattern_raw, -5, -3, mode, background));
+        CHECK(drawsLikeRaw(text_compressed, text_raw, 0, 0, mode, background));
+        CHECK(drawsLikeRaw(text_compressed, text_raw, 13, -9, mode, background));
+    }
+}
+#endif
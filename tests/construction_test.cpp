@@ -0,0 +1,174 @@
+#include <vector>
+
+#include "test_support.hpp"
+
+// OledDisplay takes any HardwareInterfaceBase. Constructing one brings up the interface, resets
+// the panel and sends the init sequence for the configured geometry and orientation.
+
+using SSD1306::HardwareInterfaceBase;
+
+namespace
+{
+// Logs the calls it receives instead of driving a bus.
+class MockInterface : public HardwareInterfaceBase
+{
+  public:
+    enum class Call
+    {
+        INITIALIZE,
+        RESET,
+        COMMANDS,
+        DATA
+    };
+
+    void initialize() override
+    {
+        calls.push_back(Call::INITIALIZE);
+    }
+
+    void sendCommand(uint8_t command) const override
+    {
+        sendCommands(&command, 1);
+    }
+
+    void sendCommands(uint8_t* bytes, size_t size) const override
+    {
+        calls.push_back(Call::COMMANDS);
+        commands.insert(commands.end(), bytes, bytes + size);
+    }
+
+    void sendData(uint8_t data) const override
+    {
+        sendDataBulk(&data, 1);
+    }
+
+    void sendDataBulk(uint8_t*, size_t size) const override
+    {
+        calls.push_back(Call::DATA);
+        dataBytes += size;
+    }
+
+    void reset() const override
+    {
+        calls.push_back(Call::RESET);
+    }
+
+    // The argument of the first occurrence of command in the init sequence, or -1.
+    int32_t argument(uint8_t command) const
+    {
+        for(size_t i = 0; i + 1 < commands.size(); ++i)
+        {
+            if(commands[i] == command)
+            {
+                return commands[i + 1];
+            }
+        }
+        return -1;
+    }
+
+    bool sent(uint8_t command) const
+    {
+        for(uint8_t byte: commands)
+        {
+            if(byte == command)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    mutable std::vector<Call> calls;
+    mutable std::vector<uint8_t> commands;
+    mutable size_t dataBytes = 0;
+};
+} // namespace
+
+TEST_CASE(construction_initializes_resets_and_configures)
+{
+    MockInterface mock;
+    SSD1306::OledDisplay<128, 64> display(mock);
+
+    CHECK(mock.calls.size() == 3);
+    CHECK(mock.calls[0] == MockInterface::Call::INITIALIZE);
+    CHECK(mock.calls[1] == MockInterface::Call::RESET);
+    CHECK(mock.calls[2] == MockInterface::Call::COMMANDS);
+    CHECK_EQUAL(mock.dataBytes, 0);
+
+    CHECK_EQUAL(mock.commands.front(), 0xAE);
+    CHECK_EQUAL(mock.commands.back(), 0xAF);
+    CHECK_EQUAL(mock.argument(0xA8), 63);
+    CHECK_EQUAL(mock.argument(0x8D), 0x14);
+    CHECK_EQUAL(mock.argument(0x20), 0x00);
+    CHECK(mock.sent(0xA6));
+    CHECK(!mock.sent(0xA7));
+}
+
+TEST_CASE(geometry_and_inversion_reach_the_init_sequence)
+{
+    MockInterface mock;
+    SSD1306::OledDisplay<128, 32, false, true> display(mock);
+
+    CHECK_EQUAL(mock.argument(0xA8), 31);
+    CHECK(mock.sent(0xA7));
+    CHECK(!mock.sent(0xA6));
+}
+
+TEST_CASE(first_display_sends_the_whole_frame)
+{
+    MockInterface mock;
+    SSD1306::OledDisplay<128, 32> display(mock);
+    mock.calls.clear();
+
+    display.display();
+    CHECK_EQUAL(mock.dataBytes, 128 * 32 / 8);
+    display.display();
+    CHECK_EQUAL(mock.dataBytes, 128 * 32 / 8);
+}
+
+TEST_CASE(displays_only_use_their_own_interface)
+{
+    MockInterface first;
+    MockInterface second;
+    SSD1306::OledDisplay<128, 64> left(first);
+    SSD1306::OledDisplay<128, 32> right(second);
+    left.display();
+    right.display();
+    first.dataBytes = 0;
+    second.dataBytes = 0;
+
+    left.drawPixel(3, 3);
+    left.display();
+    CHECK_EQUAL(first.dataBytes, 1);
+    CHECK_EQUAL(second.dataBytes, 0);
+}
+
+TEST_CASE(simulated_panel_comes_up_as_configured)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    CHECK(!panel.isInitialized());
+
+    SSD1306::OledDisplay<128, 64, false, true> display(panel);
+    CHECK(panel.isInitialized());
+    CHECK(panel.isDisplayOn());
+    CHECK(panel.isInverted());
+    CHECK_EQUAL(panel.contrast(), 0x00);
+}
+
+TEST_CASE(flip_direction_turns_the_picture_around)
+{
+    SSD1306::SimulatedSSD1306 normalPanel;
+    SSD1306::SimulatedSSD1306 flippedPanel;
+    SSD1306::OledDisplay<128, 64> normal(normalPanel);
+    SSD1306::OledDisplay<128, 64, true> flipped(flippedPanel);
+
+    normal.drawPixel(0, 0);
+    normal.display();
+    flipped.drawPixel(0, 0);
+    flipped.display();
+
+    CHECK(normalPanel.pixel(127, 63));
+    CHECK(!normalPanel.pixel(0, 0));
+    CHECK(flippedPanel.pixel(0, 0));
+    CHECK(!flippedPanel.pixel(127, 63));
+}
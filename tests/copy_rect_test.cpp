@@ -0,0 +1,218 @@
+#include "test_support.hpp"
+
+// copyRect() and scroll() against a pixel-by-pixel copy, including overlapping moves, blocks
+// reaching past the frame and the panel staying in sync through display().
+
+using Display = SSD1306::OledDisplay<128, 64>;
+using DiffDisplay = SSD1306::OledDisplay<128, 64, false, false, false, true>;
+
+namespace
+{
+struct Frame
+{
+    bool pixels[64][128];
+};
+
+Frame capture(const Display& display)
+{
+    Frame frame;
+    for(int32_t y = 0; y < 64; ++y)
+    {
+        for(int32_t x = 0; x < 128; ++x)
+        {
+            frame.pixels[y][x] = Test::bufferPixel(display, x, y);
+        }
+    }
+    return frame;
+}
+
+bool inside(int32_t x, int32_t y)
+{
+    return x >= 0 && x < 128 && y >= 0 && y < 64;
+}
+
+bool matches(const Display& display, const Frame& expected)
+{
+    for(int32_t y = 0; y < 64; ++y)
+    {
+        for(int32_t x = 0; x < 128; ++x)
+        {
+            if(Test::bufferPixel(display, x, y) != expected.pixels[y][x])
+            {
+                printf("  pixel %d, %d differs\n", x, y);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+} // namespace
+
+TEST_CASE(copy_rect_matches_per_pixel_copy)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(18);
+    uint8_t background[Display::FRAME_SIZE];
+
+    for(int32_t i = 0; i < 5000; ++i)
+    {
+        int32_t srcX = random.range(-30, 150);
+        int32_t srcY = random.range(-20, 80);
+        int32_t w = random.range(-5, 135);
+        int32_t h = random.range(-5, 75);
+        int32_t dstX = random.range(-30, 150);
+        int32_t dstY = random.range(-20, 80);
+        if(i % 4 == 0)
+        {
+            // Small overlapping moves in every direction.
+            dstX = srcX + random.range(-2, 2);
+            dstY = srcY + random.range(-8, 8);
+        }
+
+        random.fill(background, sizeof(background));
+        Test::loadFrame(display, background);
+        Frame before = capture(display);
+        Frame expected = before;
+        for(int32_t y = 0; y < h; ++y)
+        {
+            for(int32_t x = 0; x < w; ++x)
+            {
+                if(inside(srcX + x, srcY + y) && inside(dstX + x, dstY + y))
+                {
+                    expected.pixels[dstY + y][dstX + x] = before.pixels[srcY + y][srcX + x];
+                }
+            }
+        }
+
+        display.copyRect(srcX, srcY, w, h, dstX, dstY);
+        if(!CHECK(matches(display, expected)))
+        {
+            printf("  copyRect(%d, %d, %d, %d, %d, %d)\n", srcX, srcY, w, h, dstX, dstY);
+            return;
+        }
+    }
+}
+
+TEST_CASE(scroll_moves_the_frame_and_clears_what_it_exposes)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(19);
+    uint8_t background[Display::FRAME_SIZE];
+
+    for(int32_t i = 0; i < 2000; ++i)
+    {
+        int32_t dx = random.range(-20, 20);
+        int32_t dy = i % 5 == 0 ? random.range(-70, 70) : random.range(-12, 12);
+
+        random.fill(background, sizeof(background));
+        Test::loadFrame(display, background);
+        Frame before = capture(display);
+        Frame expected;
+        for(int32_t y = 0; y < 64; ++y)
+        {
+            for(int32_t x = 0; x < 128; ++x)
+            {
+                int32_t sourceX = x - dx;
+                int32_t sourceY = y - dy;
+                expected.pixels[y][x] =
+                    inside(sourceX, sourceY) && before.pixels[sourceY][sourceX];
+            }
+        }
+
+        display.scroll(dx, dy);
+        if(!CHECK(matches(display, expected)))
+        {
+            printf("  scroll(%d, %d)\n", dx, dy);
+            return;
+        }
+    }
+}
+
+TEST_CASE(scroll_stays_inside_the_clip_rectangle)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(20);
+    uint8_t background[Display::FRAME_SIZE];
+    random.fill(background, sizeof(background));
+    Test::loadFrame(display, background);
+    Frame before = capture(display);
+
+    // A chart area scrolling one column to the left, as a strip chart does.
+    display.pushClip(20, 10, 60, 30);
+    display.scroll(-1, 0);
+    display.popClip();
+
+    Frame expected = before;
+    for(int32_t y = 10; y < 40; ++y)
+    {
+        for(int32_t x = 20; x < 80; ++x)
+        {
+            expected.pixels[y][x] = x < 79 && before.pixels[y][x + 1];
+        }
+    }
+    CHECK(matches(display, expected));
+}
+
+TEST_CASE(moved_content_reaches_the_panel)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    SSD1306::SimulatedSSD1306 diffPanel;
+    DiffDisplay diffDisplay(diffPanel);
+    Test::Random random(21);
+
+    for(int32_t i = 0; i < 20; ++i)
+    {
+        int32_t x = random.range(0, 127);
+        int32_t y = random.range(0, 63);
+        int32_t w = random.range(0, 40);
+        int32_t h = random.range(0, 30);
+        display.fillRect(x, y, w, h);
+        diffDisplay.fillRect(x, y, w, h);
+    }
+    display.display();
+    diffDisplay.display();
+
+    for(int32_t i = 0; i < 2000; ++i)
+    {
+        if(i % 7 == 0)
+        {
+            int32_t dx = random.range(-4, 4);
+            int32_t dy = random.range(-4, 4);
+            display.scroll(dx, dy);
+            diffDisplay.scroll(dx, dy);
+        }
+        else
+        {
+            int32_t srcX = random.range(0, 127);
+            int32_t srcY = random.range(0, 63);
+            int32_t w = random.range(0, 60);
+            int32_t h = random.range(0, 40);
+            int32_t dstX = random.range(0, 127);
+            int32_t dstY = random.range(0, 63);
+            display.copyRect(srcX, srcY, w, h, dstX, dstY);
+            diffDisplay.copyRect(srcX, srcY, w, h, dstX, dstY);
+        }
+        if(i % 3 == 0)
+        {
+            int32_t x0 = random.range(0, 127);
+            int32_t y0 = random.range(0, 63);
+            int32_t x1 = random.range(0, 127);
+            int32_t y1 = random.range(0, 63);
+            display.drawLine(x0, y0, x1, y1);
+            diffDisplay.drawLine(x0, y0, x1, y1);
+        }
+
+        display.display();
+        diffDisplay.display();
+        if(!CHECK(Test::ramMatches(panel, display)) ||
+           !CHECK(Test::ramMatches(diffPanel, diffDisplay)) ||
+           !CHECK(memcmp(display.getBuffer(), diffDisplay.getBuffer(), Display::FRAME_SIZE) == 0))
+        {
+            return;
+        }
+    }
+}
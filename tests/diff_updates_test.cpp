@@ -0,0 +1,196 @@
+#include "test_support.hpp"
+
+// With DIFF_UPDATES, display() sends only bytes that differ from the panel, and merges changes
+// whose gap is not longer than the window cost into one address window.
+
+using Display = SSD1306::OledDisplay<128, 64, false, false, false, true>;
+using SSD1306::DrawMode;
+
+namespace
+{
+struct Ram
+{
+    uint8_t bytes[8][128];
+};
+
+Ram readRam(const SSD1306::SimulatedSSD1306& panel)
+{
+    Ram ram;
+    for(int32_t page = 0; page < 8; ++page)
+    {
+        for(int32_t column = 0; column < 128; ++column)
+        {
+            ram.bytes[page][column] = panel.ramByte(column, page);
+        }
+    }
+    return ram;
+}
+
+// Checks that the windows sent cover every changed byte, start and end on a changed byte on
+// each of their pages and do not resend more than cost unchanged bytes in a row.
+bool windowsAreMinimal(const Test::RecordingInterface& panel, const Ram& before,
+                       const Display& display, int32_t cost)
+{
+    const uint8_t* buffer = display.getBuffer();
+    bool covered[8][128] = {};
+    for(const Test::RecordingInterface::Window& window: panel.windows())
+    {
+        for(int32_t page = window.firstPage; page <= window.lastPage; ++page)
+        {
+            const uint8_t* current = &buffer[page * 128];
+            if(current[window.firstColumn] == before.bytes[page][window.firstColumn] ||
+               current[window.lastColumn] == before.bytes[page][window.lastColumn])
+            {
+                return false;
+            }
+            int32_t unchanged = 0;
+            for(int32_t column = window.firstColumn; column <= window.lastColumn; ++column)
+            {
+                covered[page][column] = true;
+                unchanged = current[column] == before.bytes[page][column] ? unchanged + 1 : 0;
+                if(unchanged > cost)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    for(int32_t page = 0; page < 8; ++page)
+    {
+        for(int32_t column = 0; column < 128; ++column)
+        {
+            if(buffer[page * 128 + column] != before.bytes[page][column] && !covered[page][column])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+} // namespace
+
+TEST_CASE(gaps_up_to_the_window_cost_are_resent)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    display.display();
+
+    // Changed columns 10 and 17 leave a gap of six unchanged bytes: one window at cost 6.
+    panel.clearLog();
+    display.drawPixel(10, 20);
+    display.drawPixel(17, 20);
+    display.display();
+    CHECK_EQUAL(panel.windows().size(), 1);
+    CHECK_EQUAL(panel.dataBytes(), 8);
+
+    // A gap of seven is cheaper as a second window.
+    panel.clearLog();
+    display.drawPixel(30, 20);
+    display.drawPixel(38, 20);
+    display.display();
+    CHECK_EQUAL(panel.windows().size(), 2);
+    CHECK_EQUAL(panel.dataBytes(), 2);
+
+    // Unless opening a window is made more expensive.
+    panel.clearLog();
+    display.setWindowCost(7);
+    display.drawPixel(50, 20);
+    display.drawPixel(58, 20);
+    display.display();
+    CHECK_EQUAL(panel.windows().size(), 1);
+    CHECK_EQUAL(panel.dataBytes(), 9);
+
+    panel.clearLog();
+    display.setWindowCost(0);
+    display.drawPixel(70, 20);
+    display.drawPixel(72, 20);
+    display.display();
+    CHECK_EQUAL(panel.windows().size(), 2);
+    CHECK(Test::ramMatches(panel, display));
+}
+
+TEST_CASE(redrawn_but_unchanged_content_is_not_sent)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    display.drawText(0, 0, "same text");
+    display.display();
+
+    panel.clearLog();
+    panel.resetStatistics();
+    display.drawText(0, 0, "same text", Fonts::FontType::FONT5X8, DrawMode::COPY);
+    display.fillRect(40, 30, 20, 20, DrawMode::XOR);
+    display.fillRect(40, 30, 20, 20, DrawMode::XOR);
+    display.display();
+    CHECK_EQUAL(panel.windows().size(), 0);
+    CHECK_EQUAL(panel.statistics().dataBytes, 0);
+}
+
+TEST_CASE(equal_runs_on_consecutive_pages_share_a_window)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    display.display();
+
+    panel.clearLog();
+    display.fillRect(20, 8, 10, 24);
+    display.display();
+    CHECK_EQUAL(panel.windows().size(), 1);
+    if(panel.windows().size() == 1)
+    {
+        CHECK_EQUAL(panel.windows()[0].firstPage, 1);
+        CHECK_EQUAL(panel.windows()[0].lastPage, 3);
+        CHECK_EQUAL(panel.windows()[0].dataBytes, 30);
+    }
+    CHECK(Test::ramMatches(panel, display));
+}
+
+TEST_CASE(random_updates_are_minimal_and_correct)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    display.display();
+    Test::Random random(9);
+
+    for(int32_t i = 0; i < 3000; ++i)
+    {
+        int32_t cost = random.range(0, 3) == 0 ? random.range(0, 40) : 6;
+        display.setWindowCost(cost);
+        for(int32_t n = random.range(1, 4); n > 0; --n)
+        {
+            switch(random.range(0, 4))
+            {
+                case 0:
+                    display.drawPixel(random.range(0, 127), random.range(0, 63), DrawMode::XOR);
+                    break;
+                case 1:
+                    display.drawLine(random.range(-10, 137), random.range(-10, 73),
+                                     random.range(-10, 137), random.range(-10, 73),
+                                     DrawMode::XOR);
+                    break;
+                case 2:
+                    display.drawText(random.range(-10, 127), random.range(-5, 63), "0123",
+                                     Fonts::FontType::FONT5X8, DrawMode::COPY);
+                    break;
+                case 3:
+                    display.fillRect(random.range(-10, 127), random.range(-5, 63),
+                                     random.range(0, 50), random.range(0, 30), DrawMode::XOR);
+                    break;
+                default:
+                    display.drawCircle(random.range(0, 127), random.range(0, 63),
+                                       random.range(0, 20));
+                    break;
+            }
+        }
+
+        Ram before = readRam(panel);
+        panel.clearLog();
+        display.display();
+        if(!CHECK(Test::ramMatches(panel, display)) ||
+           !CHECK(windowsAreMinimal(panel, before, display, cost)))
+        {
+            return;
+        }
+    }
+}
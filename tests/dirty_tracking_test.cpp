@@ -0,0 +1,123 @@
+#include "test_support.hpp"
+
+// display() sends only what was drawn since the last transfer, displayFull() everything.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+using SSD1306::DrawMode;
+
+TEST_CASE(single_digit_update_sends_one_glyph)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    display.drawText(0, 16, "Count: 1234");
+    display.display();
+    CHECK(Test::ramMatches(panel, display));
+
+    // The last digit of a 5x8 text at x = 0 starts at column 10 * 6.
+    panel.clearLog();
+    display.drawText(60, 16, "5", Fonts::FontType::FONT5X8, DrawMode::COPY);
+    display.display();
+
+    CHECK_EQUAL(panel.windows().size(), 1);
+    const Test::RecordingInterface::Window& window = panel.windows()[0];
+    CHECK_EQUAL(window.firstColumn, 60);
+    CHECK_EQUAL(window.lastColumn, 64);
+    CHECK_EQUAL(window.firstPage, 2);
+    CHECK_EQUAL(window.lastPage, 2);
+    CHECK_EQUAL(window.dataBytes, 5);
+    CHECK(Test::ramMatches(panel, display));
+
+    panel.clearLog();
+    display.displayFull();
+    CHECK_EQUAL(panel.windows().size(), 1);
+    CHECK_EQUAL(panel.dataBytes(), Display::FRAME_SIZE);
+    CHECK(Test::ramMatches(panel, display));
+}
+
+TEST_CASE(nothing_drawn_sends_nothing)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    display.display();
+
+    panel.clearLog();
+    panel.resetStatistics();
+    display.display();
+    CHECK_EQUAL(panel.windows().size(), 0);
+    CHECK_EQUAL(panel.statistics().commandBytes + panel.statistics().dataBytes, 0);
+}
+
+TEST_CASE(pages_with_the_same_span_share_a_window)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    display.display();
+
+    // Pages 1 to 3 share columns 10..29; page 6 has its own span.
+    panel.clearLog();
+    display.fillRect(10, 12, 20, 14);
+    display.drawPixel(100, 50);
+    display.display();
+
+    CHECK_EQUAL(panel.windows().size(), 2);
+    if(panel.windows().size() == 2)
+    {
+        const Test::RecordingInterface::Window& rect = panel.windows()[0];
+        CHECK_EQUAL(rect.firstColumn, 10);
+        CHECK_EQUAL(rect.lastColumn, 29);
+        CHECK_EQUAL(rect.firstPage, 1);
+        CHECK_EQUAL(rect.lastPage, 3);
+        CHECK_EQUAL(rect.dataBytes, 60);
+        CHECK_EQUAL(panel.windows()[1].dataBytes, 1);
+    }
+    CHECK(Test::ramMatches(panel, display));
+}
+
+TEST_CASE(random_drawing_keeps_panel_in_sync)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    display.display();
+    Test::Random random(1);
+
+    for(int32_t i = 0; i < 2000; ++i)
+    {
+        panel.clearLog();
+        switch(random.range(0, 6))
+        {
+            case 0:
+                display.fillRect(random.range(-5, 135), random.range(-5, 70), random.range(0, 40),
+                                 random.range(0, 40));
+                break;
+            case 1:
+                display.drawLine(random.range(-20, 150), random.range(-20, 80),
+                                 random.range(-20, 150), random.range(-20, 80));
+                break;
+            case 2:
+                display.drawText(random.range(-10, 130), random.range(-10, 70), "Hi!");
+                break;
+            case 3:
+                display.drawCircle(random.range(0, 128), random.range(0, 64), random.range(0, 20));
+                break;
+            case 4:
+                display.clearRect(random.range(0, 128), random.range(0, 64), random.range(0, 40),
+                                  random.range(0, 40));
+                break;
+            case 5:
+                display.drawPixel(random.range(-2, 130), random.range(-2, 66), DrawMode::XOR);
+                break;
+            default:
+                if(random.range(0, 20) == 0)
+                {
+                    display.clear();
+                }
+                break;
+        }
+        display.display();
+        if(!CHECK(Test::ramMatches(panel, display)) ||
+           !CHECK(panel.dataBytes() <= Display::FRAME_SIZE))
+        {
+            return;
+        }
+    }
+}
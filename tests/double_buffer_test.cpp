@@ -0,0 +1,179 @@
+#include <vector>
+
+#include "test_support.hpp"
+
+// With DOUBLE_BUFFERED, display() hands the frame to an asynchronous transfer and drawing goes on
+// in the other buffer. The interface below holds every transfer open until waitIdle(), checks
+// that the frame in flight was left alone meanwhile, and only then lets the panel see it.
+
+using Display = SSD1306::OledDisplay<128, 64, false, false, true>;
+using SSD1306::DrawMode;
+
+namespace
+{
+class DeferredInterface : public SSD1306::SimulatedSSD1306
+{
+  public:
+    void sendDataBulkAsync(uint8_t* data, size_t size) const override
+    {
+        CHECK(!busy);
+        busy = true;
+        pending = data;
+        snapshot.assign(data, data + size);
+        ++started;
+    }
+
+    bool isBusy() const override
+    {
+        return busy;
+    }
+
+    void waitIdle() const override
+    {
+        if(!busy)
+        {
+            return;
+        }
+        if(!CHECK(std::vector<uint8_t>(pending, pending + snapshot.size()) == snapshot))
+        {
+            ++corrupted;
+        }
+        busy = false;
+        SimulatedSSD1306::sendDataBulk(snapshot.data(), snapshot.size());
+        if(transferCompleteCallback != nullptr)
+        {
+            transferCompleteCallback(transferCompleteContext);
+        }
+    }
+
+    // Everything else that reaches the bus has to wait for the transfer in flight.
+    void sendCommands(uint8_t* commands, size_t size) const override
+    {
+        CHECK(!busy);
+        SimulatedSSD1306::sendCommands(commands, size);
+    }
+
+    void sendDataBulk(uint8_t* data, size_t size) const override
+    {
+        CHECK(!busy);
+        SimulatedSSD1306::sendDataBulk(data, size);
+    }
+
+    mutable bool busy = false;
+    mutable uint8_t* pending = nullptr;
+    mutable std::vector<uint8_t> snapshot;
+    mutable int32_t started = 0;
+    mutable int32_t corrupted = 0;
+};
+
+void countCompletion(void* context)
+{
+    ++*static_cast<int32_t*>(context);
+}
+
+void drawSomething(Display& display, Test::Random& random)
+{
+    switch(random.range(0, 4))
+    {
+        case 0:
+            display.fillRect(random.range(-5, 130), random.range(-5, 66), random.range(0, 40),
+                             random.range(0, 30), DrawMode::XOR);
+            break;
+        case 1:
+            display.drawLine(random.range(0, 127), random.range(0, 63), random.range(0, 127),
+                             random.range(0, 63));
+            break;
+        case 2:
+            display.drawText(random.range(-5, 125), random.range(-5, 60), "frame",
+                             Fonts::FontType::FONT5X8, DrawMode::COPY);
+            break;
+        case 3:
+            display.clearRect(random.range(0, 127), random.range(0, 63), random.range(0, 30),
+                              random.range(0, 30));
+            break;
+        default:
+            display.drawPixel(random.range(0, 127), random.range(0, 63), DrawMode::XOR);
+            break;
+    }
+}
+} // namespace
+
+TEST_CASE(display_returns_while_the_frame_is_in_flight)
+{
+    DeferredInterface panel;
+    Display display(panel);
+    int32_t completions = 0;
+    panel.setTransferCompleteCallback(countCompletion, &completions);
+
+    display.drawText(0, 0, "first");
+    display.display();
+    CHECK(panel.isBusy());
+    CHECK_EQUAL(completions, 0);
+
+    display.waitIdle();
+    CHECK(!panel.isBusy());
+    CHECK_EQUAL(completions, 1);
+    CHECK(Test::ramMatches(panel, display));
+}
+
+TEST_CASE(drawing_during_a_transfer_leaves_the_frame_in_flight_alone)
+{
+    DeferredInterface panel;
+    Display display(panel);
+    int32_t completions = 0;
+    panel.setTransferCompleteCallback(countCompletion, &completions);
+    Test::Random random(2);
+
+    for(int32_t frame = 0; frame < 500; ++frame)
+    {
+        // Drawn while the previous frame is still streaming out.
+        for(int32_t i = random.range(0, 5); i > 0; --i)
+        {
+            drawSomething(display, random);
+        }
+
+        std::vector<uint8_t> expected(display.getBuffer(),
+                                      display.getBuffer() + Display::FRAME_SIZE);
+        display.display();
+
+        // The buffer drawn next starts from the frame just handed over.
+        CHECK(std::vector<uint8_t>(display.getBuffer(),
+                                   display.getBuffer() + Display::FRAME_SIZE) == expected);
+        if(frame % 7 == 0)
+        {
+            display.waitIdle();
+            if(!CHECK(Test::ramMatches(panel, display)))
+            {
+                return;
+            }
+        }
+    }
+
+    display.waitIdle();
+    CHECK(Test::ramMatches(panel, display));
+    CHECK_EQUAL(panel.corrupted, 0);
+    CHECK_EQUAL(completions, panel.started);
+    CHECK(panel.started > 0);
+}
+
+TEST_CASE(full_frames_alternate_buffers)
+{
+    DeferredInterface panel;
+    Display display(panel);
+
+    const uint8_t* first = display.getBuffer();
+    display.displayFull();
+    const uint8_t* second = display.getBuffer();
+    CHECK(first != second);
+    CHECK(panel.pending == first);
+
+    display.drawPixel(5, 5);
+    display.displayFull();
+    CHECK(display.getBuffer() == first);
+    CHECK(panel.pending == second);
+    CHECK(panel.snapshot.size() == Display::FRAME_SIZE);
+
+    display.waitIdle();
+    CHECK(Test::ramMatches(panel, display));
+    CHECK(panel.ramPixel(5, 5));
+}
@@ -0,0 +1,142 @@
+#include <cstring>
+
+#include "primitives.hpp"
+
+// The draw modes have to agree on which pixels a primitive covers: SET, CLEAR and XOR set,
+// clear and toggle the same pixels, so XOR twice restores the frame. For shapes COPY is SET.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+using SSD1306::DrawMode;
+
+namespace
+{
+void drawClipped(Display& display, const Test::Primitive& primitive, DrawMode mode,
+                 const int32_t* clip)
+{
+    Test::Primitive drawn = primitive;
+    drawn.mode = mode;
+    if(clip != nullptr)
+    {
+        display.pushClip(clip[0], clip[1], clip[2], clip[3]);
+    }
+    Test::drawPrimitive(display, drawn);
+    display.resetClip();
+}
+} // namespace
+
+TEST_CASE(triangle_outline_is_its_three_edges)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Display reference(panel);
+    Test::Random random(31);
+
+    for(int32_t i = 0; i < 5000; ++i)
+    {
+        int32_t range = i % 4 == 0 ? 2000 : i % 4 == 1 ? 12 : 150;
+        int32_t x[3];
+        int32_t y[3];
+        for(int32_t k = 0; k < 3; ++k)
+        {
+            x[k] = 64 + random.range(-range, range);
+            y[k] = 32 + random.range(-range, range);
+        }
+        if(x[0] == x[1] && x[1] == x[2] && y[0] == y[1] && y[1] == y[2])
+        {
+            continue;
+        }
+
+        display.clear();
+        reference.clear();
+        display.drawTriangle(x[0], y[0], x[1], y[1], x[2], y[2]);
+        for(int32_t k = 0; k < 3; ++k)
+        {
+            reference.drawLine(x[k], y[k], x[(k + 1) % 3], y[(k + 1) % 3]);
+        }
+        if(!CHECK(memcmp(display.getBuffer(), reference.getBuffer(), Display::FRAME_SIZE) == 0))
+        {
+            printf("  drawTriangle(%d, %d, %d, %d, %d, %d)\n", x[0], y[0], x[1], y[1], x[2], y[2]);
+            return;
+        }
+    }
+}
+
+TEST_CASE(draw_modes_cover_the_same_pixels)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(32);
+    random.fill(Test::primitiveBitmap, sizeof(Test::primitiveBitmap));
+    uint8_t* buffer = const_cast<uint8_t*>(display.getBuffer());
+    uint8_t covered[Display::FRAME_SIZE];
+    uint8_t background[Display::FRAME_SIZE];
+
+    for(int32_t i = 0; i < 6000; ++i)
+    {
+        int32_t kind = i % Test::PRIMITIVES;
+        if(kind == 3)
+        {
+            // clearRect() has no mode.
+            continue;
+        }
+        Test::Primitive primitive =
+            i % 2 == 0 ? Test::randomPrimitive(random, kind, -40, 170) :
+                         Test::randomPrimitive(random, kind, -5, 70);
+        int32_t clipRect[4] = {random.range(-10, 100), random.range(-10, 50),
+                               random.range(0, 120), random.range(0, 60)};
+        const int32_t* clip = i % 5 == 0 ? clipRect : nullptr;
+        random.fill(background, sizeof(background));
+
+        display.clear();
+        drawClipped(display, primitive, DrawMode::SET, clip);
+        memcpy(covered, buffer, sizeof(covered));
+
+        display.clear();
+        drawClipped(display, primitive, DrawMode::XOR, clip);
+        bool xorOnEmpty = memcmp(buffer, covered, sizeof(covered)) == 0;
+
+        bool set = true;
+        bool clear = true;
+        bool toggle = true;
+        bool copy = true;
+        memcpy(buffer, background, sizeof(background));
+        drawClipped(display, primitive, DrawMode::SET, clip);
+        for(size_t k = 0; k < sizeof(covered); ++k)
+        {
+            set = set && buffer[k] == (background[k] | covered[k]);
+        }
+        memcpy(buffer, background, sizeof(background));
+        drawClipped(display, primitive, DrawMode::CLEAR, clip);
+        for(size_t k = 0; k < sizeof(covered); ++k)
+        {
+            clear = clear && buffer[k] == (background[k] & ~covered[k]);
+        }
+        memcpy(buffer, background, sizeof(background));
+        drawClipped(display, primitive, DrawMode::XOR, clip);
+        for(size_t k = 0; k < sizeof(covered); ++k)
+        {
+            toggle = toggle && buffer[k] == (background[k] ^ covered[k]);
+        }
+        drawClipped(display, primitive, DrawMode::XOR, clip);
+        bool restored = memcmp(buffer, background, sizeof(background)) == 0;
+        if(kind < Test::FIRST_SOURCE)
+        {
+            memcpy(buffer, background, sizeof(background));
+            drawClipped(display, primitive, DrawMode::COPY, clip);
+            for(size_t k = 0; k < sizeof(covered); ++k)
+            {
+                copy = copy && buffer[k] == (background[k] | covered[k]);
+            }
+        }
+
+        if(!CHECK(xorOnEmpty) || !CHECK(set) || !CHECK(clear) || !CHECK(toggle) ||
+           !CHECK(restored) || !CHECK(copy))
+        {
+            const int32_t* a = primitive.a;
+            printf("  primitive %d (%d, %d, %d, %d, %d, %d) w %d h %d r %d, clipped %d\n", kind,
+                   a[0], a[1], a[2], a[3], a[4], a[5], primitive.w, primitive.h, primitive.r,
+                   clip != nullptr);
+            return;
+        }
+    }
+}
@@ -0,0 +1,208 @@
+#include "test_support.hpp"
+
+// fillTriangle against a straightforward edge-function rasterizer: a pixel is filled when its
+// centre lies inside the triangle, and pixels on an edge only for top and left edges.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+
+namespace
+{
+struct Triangle
+{
+    int32_t x[3];
+    int32_t y[3];
+};
+
+int64_t area(const Triangle& t)
+{
+    return static_cast<int64_t>(t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) -
+           static_cast<int64_t>(t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+}
+
+// Vertices, like pixels, are given by their centres.
+bool referenceCovers(Triangle t, int32_t px, int32_t py)
+{
+    if(area(t) < 0)
+    {
+        int32_t x = t.x[1];
+        int32_t y = t.y[1];
+        t.x[1] = t.x[2];
+        t.y[1] = t.y[2];
+        t.x[2] = x;
+        t.y[2] = y;
+    }
+
+    for(int32_t k = 0; k < 3; ++k)
+    {
+        int64_t ax = t.x[k];
+        int64_t ay = t.y[k];
+        int64_t dx = t.x[(k + 1) % 3] - ax;
+        int64_t dy = t.y[(k + 1) % 3] - ay;
+        int64_t side = dx * (py - ay) - dy * (px - ax);
+        if(side < 0)
+        {
+            return false;
+        }
+        bool topOrLeft = (dy == 0 && dx > 0) || dy < 0;
+        if(side == 0 && !topOrLeft)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool matchesReference(const Display& display, const Triangle& t)
+{
+    for(int32_t y = 0; y < 64; ++y)
+    {
+        for(int32_t x = 0; x < 128; ++x)
+        {
+            if(Test::bufferPixel(display, x, y) != referenceCovers(t, x, y))
+            {
+                printf("  (%d, %d) (%d, %d) (%d, %d): pixel %d, %d differs\n", t.x[0], t.y[0],
+                       t.x[1], t.y[1], t.x[2], t.y[2], x, y);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+Triangle randomTriangle(Test::Random& random, int32_t margin)
+{
+    Triangle t;
+    for(int32_t k = 0; k < 3; ++k)
+    {
+        t.x[k] = random.range(-margin, 127 + margin);
+        t.y[k] = random.range(-margin, 63 + margin);
+    }
+    return t;
+}
+} // namespace
+
+TEST_CASE(matches_reference_on_screen)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(6);
+
+    for(int32_t i = 0; i < 2000; ++i)
+    {
+        Triangle t = randomTriangle(random, 0);
+        display.clear();
+        display.fillTriangle(t.x[0], t.y[0], t.x[1], t.y[1], t.x[2], t.y[2]);
+        if(area(t) != 0 && !CHECK(matchesReference(display, t)))
+        {
+            return;
+        }
+    }
+}
+
+TEST_CASE(matches_reference_partly_off_screen)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(7);
+
+    for(int32_t i = 0; i < 2000; ++i)
+    {
+        Triangle t = randomTriangle(random, i % 2 ? 100 : 2000);
+        display.clear();
+        display.fillTriangle(t.x[0], t.y[0], t.x[1], t.y[1], t.x[2], t.y[2]);
+        if(area(t) != 0 && !CHECK(matchesReference(display, t)))
+        {
+            return;
+        }
+    }
+}
+
+TEST_CASE(shared_edges_neither_overlap_nor_leave_gaps)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(8);
+
+    // Two triangles splitting a quadrilateral along a diagonal cover each pixel of it once.
+    for(int32_t i = 0; i < 2000; ++i)
+    {
+        Triangle first = randomTriangle(random, 20);
+        Triangle second = {{first.x[0], first.x[2], random.range(-20, 147)},
+                           {first.y[0], first.y[2], random.range(-20, 83)}};
+        display.clear();
+        display.fillTriangle(first.x[0], first.y[0], first.x[1], first.y[1], first.x[2],
+                             first.y[2], SSD1306::DrawMode::XOR);
+        display.fillTriangle(second.x[0], second.y[0], second.x[1], second.y[1], second.x[2],
+                             second.y[2], SSD1306::DrawMode::XOR);
+        bool opposite = (area(first) > 0) != (area(second) > 0);
+        if(area(first) == 0 || area(second) == 0 || !opposite)
+        {
+            continue;
+        }
+        for(int32_t y = 0; y < 64; ++y)
+        {
+            for(int32_t x = 0; x < 128; ++x)
+            {
+                bool expected = referenceCovers(first, x, y) != referenceCovers(second, x, y);
+                if(!CHECK(Test::bufferPixel(display, x, y) == expected))
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(degenerate_triangles_draw_their_segment)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Display reference(panel);
+    Test::Random random(9);
+
+    for(int32_t i = 0; i < 2000; ++i)
+    {
+        // Three points on the line through a and b, in any order; sometimes coinciding.
+        int32_t ax = random.range(-60, 180);
+        int32_t ay = random.range(-40, 100);
+        int32_t dx = random.range(-6, 6);
+        int32_t dy = i % 3 == 0 ? 0 : random.range(-6, 6);
+        int32_t steps[3] = {random.range(-8, 8), random.range(-8, 8), random.range(-8, 8)};
+        Triangle t;
+        for(int32_t k = 0; k < 3; ++k)
+        {
+            t.x[k] = ax + steps[k] * dx;
+            t.y[k] = ay + steps[k] * dy;
+        }
+
+        display.clear();
+        display.fillTriangle(t.x[0], t.y[0], t.x[1], t.y[1], t.x[2], t.y[2]);
+
+        // The segment runs between the outermost vertices: by row, or by column when flat.
+        int32_t first = 0;
+        int32_t last = 0;
+        for(int32_t k = 1; k < 3; ++k)
+        {
+            bool flat = t.y[k] == t.y[first];
+            if(flat ? t.x[k] < t.x[first] : t.y[k] < t.y[first])
+            {
+                first = k;
+            }
+            flat = t.y[k] == t.y[last];
+            if(flat ? t.x[k] > t.x[last] : t.y[k] > t.y[last])
+            {
+                last = k;
+            }
+        }
+        reference.clear();
+        reference.drawLine(t.x[first], t.y[first], t.x[last], t.y[last]);
+
+        bool same = memcmp(display.getBuffer(), reference.getBuffer(), Display::FRAME_SIZE) == 0;
+        if(!CHECK(same))
+        {
+            printf("  (%d, %d) (%d, %d) (%d, %d)\n", t.x[0], t.y[0], t.x[1], t.y[1], t.x[2],
+                   t.y[2]);
+            return;
+        }
+    }
+}
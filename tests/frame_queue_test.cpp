@@ -0,0 +1,233 @@
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "ssd1306_pipeline.hpp"
+#include "test_support.hpp"
+
+// The frame queue hands frames from a producer to a consumer thread: WAIT delivers every frame
+// once and in order, DROP_NEWEST drops what does not fit into its slots, and LATEST_WINS never
+// lets the consumer see a frame that is being overwritten, an older frame after a newer one, or
+// miss the last frame.
+
+using SSD1306::FramePolicy;
+
+namespace
+{
+constexpr size_t WORDS = 64;
+constexpr size_t FRAME_SIZE = WORDS * sizeof(uint32_t);
+
+// Every word of frame number sequence holds sequence.
+struct Frame
+{
+    explicit Frame(uint32_t sequence)
+    {
+        for(uint32_t& word: words)
+        {
+            word = sequence;
+        }
+    }
+
+    const uint8_t* bytes() const
+    {
+        return reinterpret_cast<const uint8_t*>(words);
+    }
+
+    uint32_t words[WORDS];
+};
+
+// The sequence number of a frame, or 0 if its words disagree, i.e. it was torn.
+uint32_t sequenceOf(const uint8_t* frame)
+{
+    uint32_t words[WORDS];
+    memcpy(words, frame, FRAME_SIZE);
+    for(uint32_t word: words)
+    {
+        if(word != words[0])
+        {
+            return 0;
+        }
+    }
+    return words[0];
+}
+
+// What the consumer thread saw, checked on the test thread once it has been joined.
+struct Received
+{
+    std::vector<uint32_t> sequences;
+    uint32_t torn = 0;
+};
+
+// Takes frames until stop is set and the queue is empty. Each frame is read twice with a pause
+// in between, so a producer writing into it meanwhile tears it.
+template<typename Queue>
+void consume(Queue& queue, const std::atomic<bool>& stop, Received& received)
+{
+    while(true)
+    {
+        bool stopping = stop.load();
+        const uint8_t* frame = queue.front();
+        if(frame == nullptr)
+        {
+            if(stopping)
+            {
+                return;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        uint32_t sequence = sequenceOf(frame);
+        std::this_thread::yield();
+        if(sequence == 0 || sequenceOf(frame) != sequence)
+        {
+            ++received.torn;
+        }
+        received.sequences.push_back(sequence);
+        queue.pop();
+    }
+}
+
+bool isIncreasing(const std::vector<uint32_t>& sequences)
+{
+    for(size_t i = 1; i < sequences.size(); ++i)
+    {
+        if(sequences[i] <= sequences[i - 1])
+        {
+            printf("  frame %u after frame %u\n", sequences[i], sequences[i - 1]);
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+TEST_CASE(wait_delivers_every_frame_once_in_order)
+{
+    constexpr uint32_t FRAMES = 2000;
+    SSD1306::FrameQueue<FRAME_SIZE, FramePolicy::WAIT, 3> queue;
+    std::atomic<bool> stop{false};
+    Received received;
+    std::thread consumer([&] { consume(queue, stop, received); });
+
+    for(uint32_t sequence = 1; sequence <= FRAMES; ++sequence)
+    {
+        CHECK(queue.push(Frame(sequence).bytes()));
+    }
+    stop.store(true);
+    consumer.join();
+
+    CHECK_EQUAL(received.sequences.size(), FRAMES);
+    bool inOrder = true;
+    for(size_t i = 0; i < received.sequences.size(); ++i)
+    {
+        inOrder = inOrder && received.sequences[i] == i + 1;
+    }
+    CHECK(inOrder);
+    CHECK_EQUAL(received.torn, 0);
+    CHECK_EQUAL(queue.framesSubmitted(), FRAMES);
+    CHECK_EQUAL(queue.framesSent(), FRAMES);
+    CHECK_EQUAL(queue.framesDropped(), 0);
+}
+
+TEST_CASE(drop_newest_drops_what_does_not_fit)
+{
+    constexpr uint32_t SLOTS = 4;
+    SSD1306::FrameQueue<FRAME_SIZE, FramePolicy::DROP_NEWEST, SLOTS> queue;
+    std::atomic<bool> stalled{true};
+    std::atomic<bool> stop{false};
+    Received received;
+    std::thread consumer([&] {
+        while(stalled.load())
+        {
+            std::this_thread::yield();
+        }
+        consume(queue, stop, received);
+    });
+
+    // With the consumer stalled only the first SLOTS frames find a slot.
+    uint32_t sequence = 0;
+    for(int32_t i = 0; i < 50; ++i)
+    {
+        ++sequence;
+        CHECK_EQUAL(queue.push(Frame(sequence).bytes()), sequence <= SLOTS);
+    }
+    CHECK_EQUAL(queue.framesDropped(), queue.framesSubmitted() - SLOTS);
+
+    // Once the consumer has caught up, it gets the frames accepted from then on in order.
+    stalled.store(false);
+    while(queue.framesSent() < SLOTS)
+    {
+        std::this_thread::yield();
+    }
+    for(int32_t i = 0; i < 20000; ++i)
+    {
+        queue.push(Frame(++sequence).bytes());
+    }
+    stop.store(true);
+    consumer.join();
+
+    CHECK(received.sequences.size() > SLOTS);
+    CHECK_EQUAL(received.sequences[SLOTS - 1], SLOTS);
+    CHECK_EQUAL(received.sequences[SLOTS], 51);
+    CHECK(isIncreasing(received.sequences));
+    CHECK_EQUAL(received.torn, 0);
+    CHECK_EQUAL(received.sequences.size() + queue.framesDropped(), queue.framesSubmitted());
+    CHECK_EQUAL(queue.framesSent(), received.sequences.size());
+}
+
+TEST_CASE(latest_wins_hands_over_the_newest_whole_frame)
+{
+    SSD1306::FrameQueue<FRAME_SIZE, FramePolicy::LATEST_WINS> queue;
+    CHECK(queue.front() == nullptr);
+
+    // Without a consumer every frame replaces the one before.
+    for(uint32_t sequence = 1; sequence <= 5; ++sequence)
+    {
+        CHECK(queue.push(Frame(sequence).bytes()));
+    }
+    CHECK_EQUAL(sequenceOf(queue.front()), 5);
+    queue.pop();
+    CHECK(queue.front() == nullptr);
+
+    // The frame taken stays whole while more frames are pushed.
+    queue.push(Frame(6).bytes());
+    const uint8_t* held = queue.front();
+    for(uint32_t sequence = 7; sequence <= 20; ++sequence)
+    {
+        queue.push(Frame(sequence).bytes());
+    }
+    CHECK_EQUAL(sequenceOf(held), 6);
+    queue.pop();
+    CHECK_EQUAL(sequenceOf(queue.front()), 20);
+    queue.pop();
+}
+
+TEST_CASE(latest_wins_consumer_never_sees_torn_or_older_frames)
+{
+    for(int32_t run = 0; run < 20; ++run)
+    {
+        constexpr uint32_t FRAMES = 20000;
+        SSD1306::FrameQueue<FRAME_SIZE, FramePolicy::LATEST_WINS> queue;
+        std::atomic<bool> stop{false};
+        Received received;
+        std::thread consumer([&] { consume(queue, stop, received); });
+
+        for(uint32_t sequence = 1; sequence <= FRAMES; ++sequence)
+        {
+            queue.push(Frame(sequence).bytes());
+        }
+        stop.store(true);
+        consumer.join();
+
+        bool delivered = !received.sequences.empty() && received.sequences.back() == FRAMES;
+        if(!CHECK_EQUAL(received.torn, 0) || !CHECK(isIncreasing(received.sequences)) ||
+           !CHECK(delivered))
+        {
+            printf("  run %d\n", run);
+            return;
+        }
+        CHECK_EQUAL(queue.framesSent(), received.sequences.size());
+        CHECK_EQUAL(queue.framesSubmitted(), FRAMES);
+    }
+}
@@ -0,0 +1,267 @@
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "test_support.hpp"
+
+// Draws one scene per primitive, sends it to the simulated panel and compares the panel RAM with
+// a checked-in PBM in tests/golden. With SSD1306_UPDATE_GOLDEN set in the environment the
+// images are rewritten instead; review the diff before committing them.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+using SSD1306::DrawMode;
+
+namespace
+{
+std::string ramImage(const SSD1306::SimulatedSSD1306& panel)
+{
+    std::ostringstream image;
+    image << "P1\n"
+          << SSD1306::SimulatedSSD1306::RAM_COLUMNS << " " << SSD1306::SimulatedSSD1306::RAM_ROWS
+          << "\n";
+    for(int32_t row = 0; row < SSD1306::SimulatedSSD1306::RAM_ROWS; ++row)
+    {
+        for(int32_t column = 0; column < SSD1306::SimulatedSSD1306::RAM_COLUMNS; ++column)
+        {
+            image << (panel.ramPixel(column, row) ? '1' : '0');
+        }
+        image << "\n";
+    }
+    return image.str();
+}
+
+template<typename Draw>
+void checkGolden(const char* name, Draw draw)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    display.clear();
+    draw(display);
+    display.resetClip();
+    display.displayFull();
+
+    std::string actual = ramImage(panel);
+    std::string path = std::string(GOLDEN_DIR) + "/" + name + ".pbm";
+    if(getenv("SSD1306_UPDATE_GOLDEN") != nullptr)
+    {
+        std::ofstream(path) << actual;
+        return;
+    }
+
+    std::ifstream file(path);
+    std::stringstream expected;
+    expected << file.rdbuf();
+    if(!CHECK(file.good() && expected.str() == actual))
+    {
+        std::string actualPath = std::string(name) + ".actual.pbm";
+        std::ofstream(actualPath) << actual;
+        printf("  %s differs from %s, see %s\n", name, path.c_str(), actualPath.c_str());
+    }
+}
+
+// Page layout 12x12 checker with a frame.
+const uint8_t PAGE_BITMAP[] = {
+    0xFF, 0x01, 0x33, 0x33, 0xCD, 0xCD, 0x33, 0x33, 0xCD, 0xCD, 0x01, 0xFF,
+    0x0F, 0x08, 0x0B, 0x0B, 0x08, 0x08, 0x0B, 0x0B, 0x08, 0x08, 0x08, 0x0F,
+};
+
+// Row-major 11x9 arrow, MSB first.
+const uint8_t ROW_BITMAP[] = {
+    0x04, 0x00, 0x0E, 0x00, 0x1F, 0x00, 0x3F, 0x80, 0x7F, 0xC0,
+    0xFF, 0xE0, 0x0E, 0x00, 0x0E, 0x00, 0x0E, 0x00,
+};
+
+// 20x16 compressed: a solid top half, a literal stripe and a repeated pattern.
+const uint8_t RLE_DATA[] = {
+    0xC0 | 9, 0x80 | 9, 0x00 | 3, 0x81, 0x42, 0x24, 0x18, 0x40 | 15, 0x5A,
+};
+const SSD1306::CompressedBitmap RLE_BITMAP = {20, 16, RLE_DATA, sizeof(RLE_DATA)};
+} // namespace
+
+TEST_CASE(pixels)
+{
+    checkGolden("pixels", [](Display& display) {
+        for(int32_t y = 0; y < 64; y += 5)
+        {
+            for(int32_t x = (y / 5) % 3; x < 128; x += 7)
+            {
+                display.drawPixel(x, y);
+            }
+        }
+        display.drawPixel(0, 0);
+        display.drawPixel(127, 0);
+        display.drawPixel(0, 63);
+        display.drawPixel(127, 63);
+        display.drawPixel(-1, 10);
+        display.drawPixel(128, 10);
+        display.drawPixel(10, -1);
+        display.drawPixel(10, 64);
+    });
+}
+
+TEST_CASE(lines)
+{
+    checkGolden("lines", [](Display& display) {
+        for(int32_t i = 0; i <= 8; ++i)
+        {
+            display.drawLine(32, 32, i * 8, 0);
+            display.drawLine(32, 32, 64, i * 8);
+        }
+        display.drawLine(70, 5, 125, 12);
+        display.drawLine(70, 60, 80, 20);
+        display.drawLine(100, 63, 100, 30);
+        display.drawLine(110, 40, 90, 40);
+        display.drawLine(-20, 70, 140, -10);
+        display.drawLine(-5, -5, -1, 100);
+    });
+}
+
+TEST_CASE(rectangles)
+{
+    checkGolden("rectangles", [](Display& display) {
+        display.fillRect(4, 3, 40, 30);
+        display.clearRect(10, 9, 12, 10);
+        display.drawRect(50, 2, 30, 20);
+        display.drawRect(52, 4, 1, 1);
+        display.drawRect(56, 6, 2, 9);
+        display.fillRect(85, 7, 9, 1);
+        display.fillRect(-10, 40, 20, 30);
+        display.fillRect(120, -4, 20, 12);
+        display.fillRect(60, 40, 0, 10);
+        display.drawFastHLine(20, 45, 90);
+        display.drawFastHLine(-3, 50, 10);
+        display.drawFastVLine(100, 25, 39);
+        display.drawFastVLine(105, 10, 1);
+        display.drawRect(30, 36, 50, 28);
+    });
+}
+
+TEST_CASE(triangles)
+{
+    checkGolden("triangles", [](Display& display) {
+        display.fillTriangle(5, 5, 40, 10, 15, 40);
+        display.fillTriangle(45, 60, 60, 20, 75, 60);
+        display.fillTriangle(80, 5, 80, 5, 80, 5);
+        display.fillTriangle(85, 5, 120, 5, 100, 5);
+        display.fillTriangle(100, 50, 140, 30, 150, 70);
+        display.drawTriangle(50, 2, 70, 12, 45, 16);
+        display.drawTriangle(85, 15, 125, 20, 90, 40);
+        display.drawTriangle(5, 50, 30, 50, 17, 50);
+    });
+}
+
+TEST_CASE(circles)
+{
+    checkGolden("circles", [](Display& display) {
+        display.drawCircle(20, 20, 15);
+        display.drawCircle(20, 20, 0);
+        display.drawCircle(20, 20, 1);
+        display.fillCircle(55, 20, 12);
+        display.fillCircle(80, 10, 1);
+        display.drawCircle(100, 40, 30);
+        display.fillCircle(0, 63, 10);
+        display.drawCircle(60, 50, 8);
+    });
+}
+
+TEST_CASE(ellipses)
+{
+    checkGolden("ellipses", [](Display& display) {
+        display.drawEllipse(30, 16, 25, 10);
+        display.drawEllipse(30, 16, 3, 12);
+        display.fillEllipse(90, 16, 30, 6);
+        display.fillEllipse(20, 48, 6, 14);
+        display.drawEllipse(70, 48, 0, 8);
+        display.drawEllipse(80, 48, 8, 0);
+        display.fillEllipse(120, 60, 20, 12);
+    });
+}
+
+TEST_CASE(round_rects)
+{
+    checkGolden("round_rects", [](Display& display) {
+        display.drawRoundRect(2, 2, 50, 25, 6);
+        display.drawRoundRect(56, 2, 20, 20, 20);
+        display.drawRoundRect(80, 2, 6, 6, 1);
+        display.fillRoundRect(2, 32, 50, 28, 8);
+        display.fillRoundRect(56, 32, 30, 10, 0);
+        display.fillRoundRect(90, 30, 50, 40, 12);
+    });
+}
+
+TEST_CASE(text)
+{
+    checkGolden("text", [](Display& display) {
+        display.drawText(0, 0, "Font 5x7", Fonts::FontType::FONT5X7);
+        display.drawText(0, 9, "Font 5x8", Fonts::FontType::FONT5X8);
+        display.drawText(0, 18, "Font 6x8", Fonts::FontType::FONT6X8);
+        display.drawText(0, 27, "Font 8x8", Fonts::FontType::FONT8X8);
+        display.drawText<Fonts::Font6x8>(64, 3, "tmpl 6x8");
+        display.drawChar(120, 30, 'Z');
+        display.drawText(110, 56, "cut off");
+        display.drawTextWithWrap(0, 38, "Wrapped text runs on to the next line here");
+    });
+}
+
+TEST_CASE(bitmaps)
+{
+    checkGolden("bitmaps", [](Display& display) {
+        display.drawBitmap(0, 0, PAGE_BITMAP, 12, 12);
+        display.drawBitmap(15, 3, PAGE_BITMAP, 12, 12);
+        display.drawBitmap(30, 21, PAGE_BITMAP, 12, 9);
+        display.drawBitmap(122, 58, PAGE_BITMAP, 12, 12);
+        display.drawBitmapHorizontal(50, 0, ROW_BITMAP, 11, 9);
+        display.drawBitmapHorizontal(63, 13, ROW_BITMAP, 11, 9);
+        display.drawBitmapHorizontal(-4, 40, ROW_BITMAP, 11, 9);
+        display.drawBitmap(80, 5, RLE_BITMAP);
+        display.drawBitmap(100, 27, RLE_BITMAP);
+    });
+}
+
+TEST_CASE(draw_modes)
+{
+    checkGolden("draw_modes", [](Display& display) {
+        display.fillRect(0, 0, 64, 64);
+        display.fillCircle(32, 32, 20, DrawMode::XOR);
+        display.drawText(8, 28, "CLEAR", Fonts::FontType::FONT6X8, DrawMode::CLEAR);
+        display.fillRect(64, 20, 64, 24, DrawMode::XOR);
+        display.drawLine(64, 0, 127, 63, DrawMode::XOR);
+        display.drawText(70, 28, "copy", Fonts::FontType::FONT8X8, DrawMode::COPY);
+        display.drawBitmap(70, 2, PAGE_BITMAP, 12, 12, DrawMode::XOR);
+        display.drawBitmap(90, 30, PAGE_BITMAP, 12, 12, DrawMode::COPY);
+        display.drawBitmapHorizontal(110, 50, ROW_BITMAP, 11, 9, DrawMode::CLEAR);
+        display.drawTriangle(70, 50, 100, 60, 80, 63, DrawMode::XOR);
+    });
+}
+
+TEST_CASE(viewports)
+{
+    checkGolden("viewports", [](Display& display) {
+        display.pushViewport(10, 10, 50, 30);
+        display.fillCircle(0, 0, 20);
+        display.drawRect(0, 0, 50, 30);
+        display.drawText(30, 12, "clipped");
+        display.pushClip(5, 5, 20, 20);
+        display.drawLine(-10, -10, 60, 60, DrawMode::XOR);
+        display.popClip();
+        display.popClip();
+        display.pushViewport(70, 20, 40, 40);
+        display.drawTextWithWrap(0, 0, "wraps inside the view");
+        display.popClip();
+    });
+}
+
+TEST_CASE(copy_and_scroll)
+{
+    checkGolden("copy_and_scroll", [](Display& display) {
+        display.drawText(0, 0, "copy me", Fonts::FontType::FONT8X8);
+        display.fillCircle(20, 30, 8);
+        display.copyRect(0, 0, 60, 8, 61, 13);
+        display.copyRect(10, 20, 25, 20, 3, 27);
+        display.pushClip(64, 32, 64, 32);
+        display.drawText(64, 40, "scrolled", Fonts::FontType::FONT6X8);
+        display.scroll(5, -3);
+        display.popClip();
+    });
+}
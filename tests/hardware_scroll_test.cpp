@@ -0,0 +1,198 @@
+#include <string>
+
+#include "test_support.hpp"
+
+// Start line, display offset and the continuous hardware scroll, checked on the glass of the
+// simulated panel. FLIP_DIRECTION is set so glass and frame buffer coordinates coincide.
+
+using Display = SSD1306::OledDisplay<128, 64, true>;
+using SSD1306::ScrollDirection;
+using SSD1306::ScrollInterval;
+
+namespace
+{
+void drawRandomFrame(Display& display, Test::Random& random)
+{
+    uint8_t frame[Display::FRAME_SIZE];
+    random.fill(frame, sizeof(frame));
+    Test::loadFrame(display, frame);
+    display.display();
+}
+
+// Whether the glass shows the frame buffer pixel source(x, y) at every x, y.
+template<typename Source>
+bool glassShows(const SSD1306::SimulatedSSD1306& panel, const Display& display, Source source)
+{
+    for(int32_t y = 0; y < 64; ++y)
+    {
+        for(int32_t x = 0; x < 128; ++x)
+        {
+            int32_t sourceX = x;
+            int32_t sourceY = y;
+            source(sourceX, sourceY);
+            if(panel.pixel(x, y) != Test::bufferPixel(display, sourceX, sourceY))
+            {
+                printf("  glass %d, %d should show %d, %d\n", x, y, sourceX, sourceY);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int32_t wrap(int32_t value, int32_t size)
+{
+    return ((value % size) + size) % size;
+}
+} // namespace
+
+TEST_CASE(start_line_rotates_the_picture_up)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(17);
+    drawRandomFrame(display, random);
+
+    for(int32_t line: {8, 13, 63, -8, 0})
+    {
+        display.setStartLine(line);
+        CHECK_EQUAL(display.getStartLine(), wrap(line, 64));
+        CHECK(glassShows(panel, display,
+                         [&](int32_t&, int32_t& y) { y = display.bufferRow(y); }));
+        CHECK_EQUAL(display.bufferRow(0), wrap(line, 64));
+    }
+}
+
+TEST_CASE(start_line_console_only_sends_the_new_line)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    display.display();
+    std::string lines[100];
+
+    for(int32_t n = 0; n < 100; ++n)
+    {
+        lines[n] = "line " + std::to_string(n * 37);
+        panel.resetStatistics();
+        if(n >= 8)
+        {
+            display.setStartLine(display.getStartLine() + 8);
+        }
+        int32_t row = n < 8 ? n * 8 : display.bufferRow(56);
+        display.clearRect(0, row, 128, 8);
+        display.drawText(0, row, lines[n]);
+        display.display();
+
+        // One start line command, an address window and at most one page of text.
+        const SSD1306::SimulatedSSD1306::Statistics& sent = panel.statistics();
+        if(n >= 8)
+        {
+            CHECK(sent.commandBytes <= 7);
+            CHECK(sent.dataBytes <= 128);
+        }
+
+        // The panel shows the last eight lines top down, as if drawn from scratch.
+        SSD1306::SimulatedSSD1306 referencePanel;
+        Display reference(referencePanel);
+        int32_t first = n < 8 ? 0 : n - 7;
+        for(int32_t k = first; k <= n; ++k)
+        {
+            reference.drawText(0, (k - first) * 8, lines[k]);
+        }
+        reference.display();
+        for(int32_t y = 0; y < 64; ++y)
+        {
+            for(int32_t x = 0; x < 128; ++x)
+            {
+                if(!CHECK(panel.pixel(x, y) == referencePanel.pixel(x, y)))
+                {
+                    printf("  line %d, pixel %d, %d\n", n, x, y);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(display_offset_shifts_the_rows)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(18);
+    drawRandomFrame(display, random);
+
+    for(int32_t offset: {4, 33, 63, 0})
+    {
+        display.setDisplayOffset(offset);
+        CHECK(glassShows(panel, display,
+                         [&](int32_t&, int32_t& y) { y = wrap(y + offset, 64); }));
+    }
+
+    // Start line and offset add up.
+    display.setDisplayOffset(10);
+    display.setStartLine(20);
+    CHECK(glassShows(panel, display, [&](int32_t&, int32_t& y) { y = wrap(y + 30, 64); }));
+}
+
+TEST_CASE(horizontal_scroll_moves_the_selected_pages)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(19);
+    drawRandomFrame(display, random);
+
+    // One column every 2 frames to the right, pages 2 to 5 only.
+    display.startScroll(ScrollDirection::RIGHT, 2, 5, ScrollInterval::FRAMES_2);
+    CHECK(panel.isScrolling());
+    panel.advanceFrames(2 * 10);
+    CHECK(glassShows(panel, display, [](int32_t& x, int32_t& y) {
+        if(y >= 16 && y < 48)
+        {
+            x = wrap(x - 10, 128);
+        }
+    }));
+
+    // The RAM has moved with the scroll, so stopping it has to resend the frame.
+    display.stopScroll();
+    CHECK(!panel.isScrolling());
+    display.display();
+    CHECK(Test::ramMatches(panel, display));
+
+    display.startScroll(ScrollDirection::LEFT, 0, 7, ScrollInterval::FRAMES_5);
+    panel.advanceFrames(5 * 3 + 4);
+    CHECK(glassShows(panel, display, [](int32_t& x, int32_t&) { x = wrap(x + 3, 128); }));
+    display.stopScroll();
+    display.display();
+    CHECK(Test::ramMatches(panel, display));
+}
+
+TEST_CASE(diagonal_scroll_moves_the_vertical_area_up)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(20);
+    drawRandomFrame(display, random);
+
+    display.setVerticalScrollArea(0, 64);
+    display.startScroll(ScrollDirection::LEFT, 0, 7, ScrollInterval::FRAMES_3, 1);
+    panel.advanceFrames(3 * 5);
+    CHECK(glassShows(panel, display, [](int32_t& x, int32_t& y) {
+        x = wrap(x + 5, 128);
+        y = wrap(y + 5, 64);
+    }));
+    display.stopScroll();
+    display.display();
+
+    // With a fixed area of 16 rows on top only the 48 rows below move up, two per step.
+    display.setVerticalScrollArea(16, 48);
+    display.startScroll(ScrollDirection::RIGHT, 0, 7, ScrollInterval::FRAMES_2, 2);
+    panel.advanceFrames(2 * 7);
+    CHECK(glassShows(panel, display, [](int32_t& x, int32_t& y) {
+        x = wrap(x - 7, 128);
+        if(y >= 16)
+        {
+            y = 16 + wrap(y - 16 + 14, 48);
+        }
+    }));
+    display.stopScroll();
+}
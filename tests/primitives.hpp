@@ -0,0 +1,152 @@
+#pragma once
+
+#include "test_support.hpp"
+
+// Every drawing primitive behind one call with random arguments, for tests that draw the same
+// shapes in two ways and compare the results.
+namespace Test
+{
+constexpr int32_t PRIMITIVES = 20;
+
+// Kinds from FIRST_SOURCE on draw text or bitmaps, whose COPY mode also clears pixels.
+constexpr int32_t FIRST_SOURCE = 15;
+
+struct Primitive
+{
+    int32_t kind;
+    int32_t a[6];
+    int32_t w;
+    int32_t h;
+    int32_t r;
+    SSD1306::DrawMode mode;
+};
+
+// Source data of the bitmap kinds; fill primitiveBitmap before drawing them.
+inline uint8_t primitiveBitmap[64 * 8];
+inline uint8_t compressedData[600];
+inline SSD1306::CompressedBitmap compressedBitmap;
+
+inline void makeCompressed(Random& random)
+{
+    size_t size = 0;
+    int32_t width = random.range(1, 40);
+    int32_t height = random.range(1, 40);
+    int32_t left = width * ((height + 7) / 8);
+    while(left > 0)
+    {
+        int32_t length = random.range(1, 64);
+        length = length < left ? length : left;
+        int32_t type = random.range(0, 3);
+        compressedData[size++] = static_cast<uint8_t>((type << 6) | (length - 1));
+        for(int32_t i = 0; i < (type == 0 ? length : type == 1 ? 1 : 0); ++i)
+        {
+            compressedData[size++] = random.byte();
+        }
+        left -= length;
+    }
+    compressedBitmap = {static_cast<uint16_t>(width), static_cast<uint16_t>(height),
+                        compressedData, size};
+}
+
+// Random arguments for primitive kind, with coordinates in low..high and a random mode.
+inline Primitive randomPrimitive(Random& random, int32_t kind, int32_t low, int32_t high)
+{
+    Primitive primitive;
+    primitive.kind = kind;
+    for(int32_t& value: primitive.a)
+    {
+        value = random.range(low, high);
+    }
+    primitive.w = random.range(-3, 70);
+    primitive.h = random.range(-3, 70);
+    primitive.r = random.range(-2, 40);
+    primitive.mode = static_cast<SSD1306::DrawMode>(random.range(0, 3));
+    if(kind == 19)
+    {
+        makeCompressed(random);
+    }
+    if(kind >= 17)
+    {
+        primitive.w = random.range(1, 64);
+        primitive.h = random.range(1, 64);
+    }
+    return primitive;
+}
+
+// Draws one primitive with all coordinates moved by dx, dy.
+template<typename Target>
+void drawPrimitive(Target& display, const Primitive& primitive, int32_t dx = 0, int32_t dy = 0)
+{
+    const int32_t* a = primitive.a;
+    int32_t w = primitive.w;
+    int32_t h = primitive.h;
+    int32_t r = primitive.r;
+    SSD1306::DrawMode mode = primitive.mode;
+    const char text[] = "Hello, clip!";
+    switch(primitive.kind)
+    {
+        case 0:
+            display.drawPixel(a[0] + dx, a[1] + dy, mode);
+            break;
+        case 1:
+            display.drawLine(a[0] + dx, a[1] + dy, a[2] + dx, a[3] + dy, mode);
+            break;
+        case 2:
+            display.fillRect(a[0] + dx, a[1] + dy, w, h, mode);
+            break;
+        case 3:
+            display.clearRect(a[0] + dx, a[1] + dy, w, h);
+            break;
+        case 4:
+            display.drawRect(a[0] + dx, a[1] + dy, w, h, mode);
+            break;
+        case 5:
+            display.drawFastHLine(a[0] + dx, a[1] + dy, w, mode);
+            break;
+        case 6:
+            display.drawFastVLine(a[0] + dx, a[1] + dy, h, mode);
+            break;
+        case 7:
+            display.fillTriangle(a[0] + dx, a[1] + dy, a[2] + dx, a[3] + dy, a[4] + dx, a[5] + dy,
+                                 mode);
+            break;
+        case 8:
+            display.drawTriangle(a[0] + dx, a[1] + dy, a[2] + dx, a[3] + dy, a[4] + dx, a[5] + dy,
+                                 mode);
+            break;
+        case 9:
+            display.drawCircle(a[0] + dx, a[1] + dy, r, mode);
+            break;
+        case 10:
+            display.fillCircle(a[0] + dx, a[1] + dy, r, mode);
+            break;
+        case 11:
+            display.drawEllipse(a[0] + dx, a[1] + dy, r, w, mode);
+            break;
+        case 12:
+            display.fillEllipse(a[0] + dx, a[1] + dy, r, w, mode);
+            break;
+        case 13:
+            display.drawRoundRect(a[0] + dx, a[1] + dy, w, h, r, mode);
+            break;
+        case 14:
+            display.fillRoundRect(a[0] + dx, a[1] + dy, w, h, r, mode);
+            break;
+        case 15:
+            display.drawText(a[0] + dx, a[1] + dy, text, Fonts::FontType::FONT5X8, mode);
+            break;
+        case 16:
+            display.template drawText<Fonts::Font8x8>(a[0] + dx, a[1] + dy, text, mode);
+            break;
+        case 17:
+            display.drawBitmap(a[0] + dx, a[1] + dy, primitiveBitmap, w, h, mode);
+            break;
+        case 18:
+            display.drawBitmapHorizontal(a[0] + dx, a[1] + dy, primitiveBitmap, w, h, mode);
+            break;
+        default:
+            display.drawBitmap(a[0] + dx, a[1] + dy, compressedBitmap, mode);
+            break;
+    }
+}
+} // namespace Test
@@ -0,0 +1,265 @@
+#include <string>
+#include <vector>
+
+#include "ssd1306_scene.hpp"
+#include "test_support.hpp"
+
+// Scene redraws only the damaged areas. After every render() the frame buffer has to equal a
+// full redraw of the same elements, which the test keeps in a model of its own.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+using TestScene = SSD1306::Scene<Display, 16>;
+
+namespace
+{
+enum class Kind
+{
+    TEXT,
+    RECT,
+    FILLED_RECT,
+    LINE,
+    CIRCLE,
+    BITMAP
+};
+
+struct Model
+{
+    TestScene::Handle handle;
+    Kind kind;
+    int32_t x;
+    int32_t y;
+    int32_t w; // Line end point x, circle radius
+    int32_t h; // Line end point y
+    std::string text;
+    Fonts::FontType font;
+    const uint8_t* bitmap;
+    bool visible;
+};
+
+uint8_t bitmaps[2][16 * 3];
+
+void drawModel(Display& display, const std::vector<Model>& models)
+{
+    display.clear();
+    for(const Model& model: models)
+    {
+        if(!model.visible)
+        {
+            continue;
+        }
+        switch(model.kind)
+        {
+            case Kind::TEXT:
+                display.drawText(model.x, model.y, model.text, model.font);
+                break;
+            case Kind::RECT:
+                display.drawRect(model.x, model.y, model.w, model.h);
+                break;
+            case Kind::FILLED_RECT:
+                display.fillRect(model.x, model.y, model.w, model.h);
+                break;
+            case Kind::LINE:
+                display.drawLine(model.x, model.y, model.w, model.h);
+                break;
+            case Kind::CIRCLE:
+                display.drawCircle(model.x, model.y, model.w);
+                break;
+            case Kind::BITMAP:
+                display.drawBitmap(model.x, model.y, model.bitmap, model.w, model.h);
+                break;
+        }
+    }
+}
+
+void add(TestScene& scene, std::vector<Model>& models, Test::Random& random)
+{
+    Model model = {};
+    model.visible = true;
+    model.x = random.range(-10, 120);
+    model.y = random.range(-10, 60);
+    model.kind = static_cast<Kind>(random.range(0, 5));
+    switch(model.kind)
+    {
+        case Kind::TEXT:
+            model.text = std::to_string(random.next() % 100000);
+            model.font = static_cast<Fonts::FontType>(random.range(0, 3));
+            model.handle = scene.addText(model.x, model.y, model.text.c_str(), model.font);
+            break;
+        case Kind::RECT:
+        case Kind::FILLED_RECT:
+            model.w = random.range(1, 30);
+            model.h = random.range(1, 20);
+            model.handle =
+                scene.addRect(model.x, model.y, model.w, model.h, model.kind == Kind::FILLED_RECT);
+            break;
+        case Kind::LINE:
+            model.w = random.range(-10, 137);
+            model.h = random.range(-10, 73);
+            model.handle = scene.addLine(model.x, model.y, model.w, model.h);
+            break;
+        case Kind::CIRCLE:
+            model.w = random.range(0, 20);
+            model.handle = scene.addCircle(model.x, model.y, model.w);
+            break;
+        case Kind::BITMAP:
+            model.w = 16;
+            model.h = random.range(1, 24);
+            model.bitmap = bitmaps[0];
+            model.handle = scene.addBitmap(model.x, model.y, model.bitmap, model.w, model.h);
+            break;
+    }
+    if(model.handle != TestScene::INVALID_HANDLE)
+    {
+        models.push_back(model);
+    }
+}
+
+void change(TestScene& scene, std::vector<Model>& models, Test::Random& random)
+{
+    size_t index = random.next() % models.size();
+    Model& model = models[index];
+    switch(random.range(0, 5))
+    {
+        case 0:
+            scene.remove(model.handle);
+            models.erase(models.begin() + index);
+            break;
+        case 1:
+        {
+            int32_t x = random.range(-10, 120);
+            int32_t y = random.range(-10, 60);
+            scene.moveTo(model.handle, x, y);
+            if(model.kind == Kind::LINE)
+            {
+                model.w += x - model.x;
+                model.h += y - model.y;
+            }
+            model.x = x;
+            model.y = y;
+            break;
+        }
+        case 2:
+            if(model.kind == Kind::TEXT)
+            {
+                model.text = std::to_string(random.next() % 1000);
+                scene.setText(model.handle, model.text.c_str());
+            }
+            break;
+        case 3:
+            if(model.kind == Kind::RECT || model.kind == Kind::FILLED_RECT)
+            {
+                model.w = random.range(1, 30);
+                model.h = random.range(1, 20);
+                scene.resize(model.handle, model.w, model.h);
+            }
+            else if(model.kind == Kind::CIRCLE)
+            {
+                model.w = random.range(0, 20);
+                scene.resize(model.handle, model.w);
+            }
+            break;
+        case 4:
+            if(model.kind == Kind::BITMAP)
+            {
+                model.bitmap = model.bitmap == bitmaps[0] ? bitmaps[1] : bitmaps[0];
+                scene.setBitmap(model.handle, model.bitmap);
+            }
+            break;
+        default:
+            model.visible = random.range(0, 1) == 1;
+            scene.setVisible(model.handle, model.visible);
+            break;
+    }
+}
+} // namespace
+
+TEST_CASE(incremental_render_matches_full_redraw)
+{
+    Test::Random random(16);
+    random.fill(bitmaps[0], sizeof(bitmaps[0]));
+    random.fill(bitmaps[1], sizeof(bitmaps[1]));
+
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Display reference(panel);
+    TestScene scene(display);
+    std::vector<Model> models;
+    size_t incremental = 0;
+    int32_t frames = 0;
+
+    for(int32_t i = 0; i < 20000; ++i)
+    {
+        if(models.empty() || (models.size() < 16 && random.range(0, 3) == 0))
+        {
+            add(scene, models, random);
+        }
+        else
+        {
+            change(scene, models, random);
+        }
+        if(random.range(0, 2) != 0)
+        {
+            continue;
+        }
+
+        scene.render();
+        panel.resetStatistics();
+        display.display();
+        incremental += panel.statistics().dataBytes;
+        ++frames;
+
+        drawModel(reference, models);
+        bool same = memcmp(display.getBuffer(), reference.getBuffer(), Display::FRAME_SIZE) == 0;
+        if(!CHECK(same) || !CHECK(Test::ramMatches(panel, display)))
+        {
+            printf("  step %d\n", i);
+            return;
+        }
+    }
+
+    // Sending only the damage has to beat resending the frame by a wide margin.
+    CHECK(incremental < frames * Display::FRAME_SIZE / 4);
+}
+
+TEST_CASE(reused_slots_are_drawn_last)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Display reference(panel);
+    TestScene scene(display);
+
+    TestScene::Handle first = scene.addRect(10, 10, 40, 20, true);
+    TestScene::Handle second = scene.addRect(30, 15, 40, 20, true);
+    scene.addText(20, 20, "on top");
+    scene.render();
+
+    // The freed slot is handed out again, but the new element goes on top of the others.
+    scene.remove(first);
+    TestScene::Handle third = scene.addText(32, 20, "XOR", Fonts::FontType::FONT8X8);
+    CHECK_EQUAL(third, first);
+    scene.setVisible(second, false);
+    scene.setVisible(second, true);
+    scene.render();
+
+    reference.fillRect(30, 15, 40, 20);
+    reference.drawText(20, 20, "on top");
+    reference.drawText(32, 20, "XOR", Fonts::FontType::FONT8X8);
+    CHECK(memcmp(display.getBuffer(), reference.getBuffer(), Display::FRAME_SIZE) == 0);
+}
+
+TEST_CASE(invalidate_repairs_foreign_drawing)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Display reference(panel);
+    TestScene scene(display);
+    scene.addCircle(64, 32, 20);
+    scene.render();
+
+    display.fillRect(0, 0, 128, 64);
+    scene.invalidate();
+    scene.render();
+
+    reference.drawCircle(64, 32, 20);
+    CHECK(memcmp(display.getBuffer(), reference.getBuffer(), Display::FRAME_SIZE) == 0);
+}
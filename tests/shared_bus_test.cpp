@@ -0,0 +1,330 @@
+#include <cstring>
+#include <vector>
+
+#include "ssd1306_shared_bus.hpp"
+#include "test_support.hpp"
+
+// The shared bus has to hand every port's bytes to that port's panel unchanged and in order,
+// whatever the queue wrap-around and segment merging do to them, and it has to pick the slices
+// by priority first and take turns between ports of equal priority.
+
+namespace
+{
+struct Slice
+{
+    int32_t port;
+    bool command;
+    size_t length;
+};
+
+// Panel interface that logs every transfer it gets and stays busy for a few polls after each,
+// so that slices are still in flight while the ports queue more.
+class Target : public SSD1306::HardwareInterfaceBase
+{
+  public:
+    struct Byte
+    {
+        bool command;
+        uint8_t value;
+    };
+
+    Target(int32_t port, std::vector<Slice>& slices, int32_t busyPolls = 0) :
+        port(port),
+        slices(slices),
+        busyPolls(busyPolls)
+    {
+    }
+
+    void initialize() override
+    {
+    }
+
+    void sendCommand(uint8_t command) const override
+    {
+        receive(true, &command, 1);
+    }
+
+    void sendCommands(uint8_t* commands, size_t size) const override
+    {
+        receive(true, commands, size);
+    }
+
+    void sendData(uint8_t data) const override
+    {
+        receive(false, &data, 1);
+    }
+
+    void sendDataBulk(uint8_t* data, size_t size) const override
+    {
+        receive(false, data, size);
+    }
+
+    void reset() const override
+    {
+    }
+
+    bool isBusy() const override
+    {
+        if(polls > 0)
+        {
+            --polls;
+            return true;
+        }
+        return false;
+    }
+
+    const std::vector<Byte>& bytes() const
+    {
+        return received;
+    }
+
+  private:
+    void receive(bool command, const uint8_t* bytes, size_t size) const
+    {
+        slices.push_back({port, command, size});
+        for(size_t i = 0; i < size; ++i)
+        {
+            received.push_back({command, bytes[i]});
+        }
+        polls = busyPolls;
+    }
+
+    int32_t port;
+    std::vector<Slice>& slices;
+    int32_t busyPolls;
+    mutable int32_t polls = 0;
+    mutable std::vector<Byte> received;
+};
+
+// Simulated panel that stays busy for a few polls after every data transfer.
+class SlowPanel : public SSD1306::SimulatedSSD1306
+{
+  public:
+    void sendDataBulkAsync(uint8_t* data, size_t size) const override
+    {
+        sendDataBulk(data, size);
+        polls = 3;
+    }
+
+    bool isBusy() const override
+    {
+        if(polls > 0)
+        {
+            --polls;
+            return true;
+        }
+        return false;
+    }
+
+  private:
+    mutable int32_t polls = 0;
+};
+
+template<typename Port>
+void sendData(Port& port, size_t size, uint8_t value = 0)
+{
+    std::vector<uint8_t> bytes(size, value);
+    port.sendDataBulk(bytes.data(), bytes.size());
+}
+
+bool slicesAre(const std::vector<Slice>& slices, const std::vector<Slice>& expected)
+{
+    bool same = slices.size() == expected.size();
+    for(size_t i = 0; same && i < slices.size(); ++i)
+    {
+        same = slices[i].port == expected[i].port && slices[i].command == expected[i].command &&
+               slices[i].length == expected[i].length;
+    }
+    if(!same)
+    {
+        for(const Slice& slice: slices)
+        {
+            printf("  port %d, %s, %zu bytes\n", slice.port, slice.command ? "commands" : "data",
+                   slice.length);
+        }
+    }
+    return same;
+}
+} // namespace
+
+TEST_CASE(priority_port_goes_first_and_equal_ports_take_turns)
+{
+    std::vector<Slice> slices;
+    Target left(0, slices);
+    Target urgent(1, slices);
+    Target right(2, slices);
+    SSD1306::SharedBus<3> bus;
+    bus.setSliceSize(100);
+    auto& leftPort = bus.attach(0, left);
+    auto& urgentPort = bus.attach(1, urgent, 1);
+    auto& rightPort = bus.attach(2, right);
+
+    sendData(leftPort, 250);
+    sendData(urgentPort, 150);
+    sendData(rightPort, 250);
+    bus.flush();
+    CHECK(bus.isIdle());
+    CHECK(slicesAre(slices, {{1, false, 100},
+                             {1, false, 50},
+                             {2, false, 100},
+                             {0, false, 100},
+                             {2, false, 100},
+                             {0, false, 100},
+                             {2, false, 50},
+                             {0, false, 50}}));
+
+    // Queued while the left panel's slice is on the bus, the urgent port goes next.
+    slices.clear();
+    sendData(leftPort, 300);
+    bus.service();
+    uint8_t commands[] = {0xAE, 0xAF};
+    urgentPort.sendCommands(commands, sizeof(commands));
+    bus.flush();
+    CHECK(slicesAre(slices,
+                    {{0, false, 100}, {1, true, 2}, {0, false, 100}, {0, false, 100}}));
+    CHECK_EQUAL(bus.statistics(0).bytes, 550);
+    CHECK_EQUAL(bus.statistics(0).transfers, 6);
+    CHECK_EQUAL(bus.statistics(1).bytes, 152);
+}
+
+TEST_CASE(sends_of_one_kind_merge_and_kinds_never_mix)
+{
+    std::vector<Slice> slices;
+    Target target(0, slices);
+    SSD1306::SharedBus<1> bus;
+    auto& port = bus.attach(0, target);
+
+    uint8_t window[] = {0x21, 0, 127, 0x22, 0, 7};
+    port.sendCommands(window, 3);
+    port.sendCommands(window + 3, 3);
+    sendData(port, 10);
+    port.sendData(0x55);
+    port.sendCommand(0xAF);
+    bus.flush();
+    CHECK(slicesAre(slices, {{0, true, 6}, {0, false, 11}, {0, true, 1}}));
+    CHECK_EQUAL(target.bytes().size(), 18);
+    CHECK_EQUAL(target.bytes()[3].value, 0x22);
+    CHECK_EQUAL(target.bytes()[16].value, 0x55);
+}
+
+TEST_CASE(full_queues_wrap_without_losing_or_reordering_bytes)
+{
+    constexpr size_t QUEUE_SIZE = 64;
+    constexpr size_t SLICE = 24;
+    std::vector<Slice> slices;
+    Target first(0, slices, 2);
+    Target second(1, slices, 1);
+    const Target* targets[] = {&first, &second};
+    SSD1306::SharedBus<2, QUEUE_SIZE> bus;
+    bus.setSliceSize(SLICE);
+    decltype(bus)::Port* ports[] = {&bus.attach(0, first), &bus.attach(1, second)};
+    std::vector<Target::Byte> expected[2];
+    Test::Random random(81);
+
+    for(int32_t i = 0; i < 3000; ++i)
+    {
+        int32_t index = random.range(0, 1);
+        bool command = random.range(0, 1) == 1;
+        // Mostly single bytes, which run out of segments before the queue is full, and now and
+        // then more than the whole queue.
+        size_t size = random.range(0, 3) != 0 ? 1 : random.range(2, 3 * QUEUE_SIZE);
+        std::vector<uint8_t> bytes(size);
+        random.fill(bytes.data(), bytes.size());
+        for(uint8_t value: bytes)
+        {
+            expected[index].push_back({command, value});
+        }
+        if(command)
+        {
+            ports[index]->sendCommands(bytes.data(), bytes.size());
+        }
+        else
+        {
+            ports[index]->sendDataBulk(bytes.data(), bytes.size());
+        }
+        if(random.range(0, 7) == 0)
+        {
+            bus.service();
+        }
+    }
+    bus.flush();
+    CHECK(bus.isIdle());
+
+    size_t total = 0;
+    for(int32_t index = 0; index < 2; ++index)
+    {
+        const std::vector<Target::Byte>& received = targets[index]->bytes();
+        bool same = received.size() == expected[index].size();
+        for(size_t i = 0; same && i < received.size(); ++i)
+        {
+            same = received[i].command == expected[index][i].command &&
+                   received[i].value == expected[index][i].value;
+        }
+        CHECK(same);
+        CHECK_EQUAL(bus.statistics(index).bytes, expected[index].size());
+        total += expected[index].size();
+    }
+    CHECK(total > 100 * QUEUE_SIZE);
+
+    bool sliced = true;
+    for(const Slice& slice: slices)
+    {
+        sliced = sliced && slice.length > 0 && slice.length <= SLICE;
+    }
+    CHECK(sliced);
+}
+
+TEST_CASE(panels_show_their_own_frames)
+{
+    SlowPanel panels[3];
+    SSD1306::SharedBus<3, 256> bus;
+    bus.setSliceSize(48);
+    SSD1306::OledDisplay<128, 64> first(bus.attach(0, panels[0]));
+    SSD1306::OledDisplay<128, 32> second(bus.attach(1, panels[1], 1));
+    SSD1306::OledDisplay<128, 64, false, false, false, true> third(bus.attach(2, panels[2]));
+    Test::Random random(82);
+
+    for(int32_t frame = 0; frame < 200; ++frame)
+    {
+        for(int32_t count = random.range(1, 6); count > 0; --count)
+        {
+            int32_t x = random.range(-10, 130);
+            int32_t y = random.range(-10, 70);
+            int32_t w = random.range(1, 60);
+            int32_t h = random.range(1, 30);
+            first.fillRect(x, y, w, h, SSD1306::DrawMode::XOR);
+            second.drawRect(y, x / 4, h, w / 2, SSD1306::DrawMode::XOR);
+            third.fillCircle(x, y, h / 2, SSD1306::DrawMode::XOR);
+        }
+        first.display();
+        second.display();
+        third.display();
+        if(frame % 3 == 0)
+        {
+            bus.flush();
+            if(!CHECK(Test::ramMatches(panels[0], first)) ||
+               !CHECK(Test::ramMatches(panels[1], second)) ||
+               !CHECK(Test::ramMatches(panels[2], third)))
+            {
+                printf("  frame %d\n", frame);
+                return;
+            }
+        }
+        else
+        {
+            for(int32_t steps = random.range(0, 20); steps > 0; --steps)
+            {
+                bus.service();
+            }
+        }
+    }
+    bus.flush();
+
+    CHECK(Test::ramMatches(panels[0], first));
+    CHECK(Test::ramMatches(panels[1], second));
+    CHECK(Test::ramMatches(panels[2], third));
+    for(const SlowPanel& panel: panels)
+    {
+        CHECK(panel.isDisplayOn());
+    }
+}
@@ -0,0 +1,201 @@
+#include <vector>
+
+#include "ssd1306_strip_chart.hpp"
+#include "test_support.hpp"
+
+// StripChart renders incrementally: after any sequence of pushes and renders the plot has to be
+// the same as a chart that got all samples at once and rendered once.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+using Chart = SSD1306::StripChart<Display>;
+
+namespace
+{
+// Lit rows of frame buffer column x, top down.
+std::vector<int32_t> litRows(const Display& display, int32_t x)
+{
+    std::vector<int32_t> rows;
+    for(int32_t y = 0; y < 64; ++y)
+    {
+        if(Test::bufferPixel(display, x, y))
+        {
+            rows.push_back(y);
+        }
+    }
+    return rows;
+}
+
+std::vector<int32_t> span(int32_t first, int32_t last)
+{
+    std::vector<int32_t> rows;
+    for(int32_t y = first; y <= last; ++y)
+    {
+        rows.push_back(y);
+    }
+    return rows;
+}
+} // namespace
+
+TEST_CASE(columns_span_to_the_previous_sample)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Chart chart(display, 0, 0, 4, 11);
+    chart.setRange(0, 10);
+    chart.push(0);
+    chart.push(10);
+    chart.push(5);
+    chart.render();
+
+    CHECK(litRows(display, 0).empty());
+    CHECK(litRows(display, 1) == span(10, 10));
+    CHECK(litRows(display, 2) == span(0, 10));
+    CHECK(litRows(display, 3) == span(0, 5));
+    CHECK(litRows(display, 4).empty());
+}
+
+TEST_CASE(columns_keep_minimum_and_maximum_of_their_samples)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Chart chart(display, 0, 0, 4, 11);
+    chart.setRange(0, 10);
+    chart.setSamplesPerColumn(3);
+    for(int32_t sample: {1, 9, 4, 6, 7})
+    {
+        chart.push(sample);
+    }
+    chart.render();
+
+    // 6 and 7 wait for a third sample.
+    CHECK(litRows(display, 2).empty());
+    CHECK(litRows(display, 3) == span(1, 9));
+
+    chart.push(2);
+    chart.render();
+    CHECK(litRows(display, 2) == span(1, 9));
+    CHECK(litRows(display, 3) == span(3, 8));
+}
+
+TEST_CASE(autoscale_fits_the_visible_samples)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Chart chart(display, 10, 10, 20, 30);
+    for(int32_t i = 0; i < 40; ++i)
+    {
+        chart.push(i < 20 ? 1000 : i);
+    }
+    chart.render();
+
+    // The spike has scrolled out of the 20 visible columns.
+    CHECK_EQUAL(chart.low(), 20);
+    CHECK_EQUAL(chart.high(), 39);
+}
+
+TEST_CASE(incremental_render_matches_a_fresh_chart)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    SSD1306::SimulatedSSD1306 referencePanel;
+    Display display(panel);
+    Display reference(referencePanel);
+    Test::Random random(19);
+    uint8_t background[Display::FRAME_SIZE];
+
+    for(int32_t trial = 0; trial < 40; ++trial)
+    {
+        int32_t x = random.range(0, 20);
+        int32_t y = random.range(0, 20);
+        int32_t w = random.range(1, 110);
+        int32_t h = random.range(1, 44);
+        int32_t samplesPerColumn = random.range(1, 3);
+        bool fixed = trial % 3 == 0;
+
+        // Whatever is around the chart has to stay untouched.
+        random.fill(background, sizeof(background));
+        Test::loadFrame(display, background);
+        display.display();
+        Chart chart(display, x, y, w, h);
+        chart.setSamplesPerColumn(samplesPerColumn);
+        if(fixed)
+        {
+            chart.setRange(-20, 300);
+        }
+
+        std::vector<int32_t> samples;
+        int32_t value = 100;
+        for(int32_t step = 0; step < 300; ++step)
+        {
+            for(int32_t n = random.range(0, 3); n > 0; --n)
+            {
+                value += random.range(-20, 20);
+                if(random.range(0, 49) == 0)
+                {
+                    value = random.range(-50, 350);
+                }
+                samples.push_back(value);
+                chart.push(value);
+            }
+            if(step == 150)
+            {
+                chart.clear();
+                samples.clear();
+            }
+            chart.render();
+            display.display();
+            if(step % 7 != 0)
+            {
+                continue;
+            }
+
+            Test::loadFrame(reference, background);
+            Chart fresh(reference, x, y, w, h);
+            fresh.setSamplesPerColumn(samplesPerColumn);
+            if(fixed)
+            {
+                fresh.setRange(-20, 300);
+            }
+            for(int32_t sample: samples)
+            {
+                fresh.push(sample);
+            }
+            fresh.render();
+
+            bool same =
+                memcmp(display.getBuffer(), reference.getBuffer(), Display::FRAME_SIZE) == 0;
+            if(!CHECK(same) || !CHECK(Test::ramMatches(panel, display)))
+            {
+                printf("  trial %d, step %d\n", trial, step);
+                return;
+            }
+        }
+    }
+}
+
+TEST_CASE(charts_without_area_draw_nothing)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    Display display(panel);
+    Test::Random random(20);
+    uint8_t background[Display::FRAME_SIZE];
+    random.fill(background, sizeof(background));
+    const int32_t sizes[][2] = {{0, 20}, {20, 0}, {-5, 20}, {20, -1}, {0, 0}, {-3, -3}};
+
+    for(const int32_t* size: sizes)
+    {
+        Test::loadFrame(display, background);
+        Chart chart(display, 10, 10, size[0], size[1]);
+        chart.setSamplesPerColumn(2);
+        for(int32_t i = 0; i < 300; ++i)
+        {
+            chart.push(i * 7 % 50);
+            chart.render();
+        }
+        chart.setRange(0, 0);
+        chart.render();
+        if(!CHECK(memcmp(display.getBuffer(), background, sizeof(background)) == 0))
+        {
+            printf("  %d x %d\n", size[0], size[1]);
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#include <vector>
+
+#include "primitives.hpp"
+
+// Rendering through strips has to put exactly the bytes on the panel that drawing the same
+// calls into a full frame buffer does, whatever the strip height, and also where calls cross
+// strip boundaries or are drawn through viewports.
+
+using SSD1306::DrawMode;
+
+namespace
+{
+// Primitives, plus pushing a viewport and popping it again.
+constexpr int32_t PUSH_VIEWPORT = Test::PRIMITIVES;
+constexpr int32_t POP_CLIP = Test::PRIMITIVES + 1;
+
+std::vector<Test::Primitive> randomFrame(Test::Random& random)
+{
+    std::vector<Test::Primitive> calls;
+    for(int32_t count = random.range(1, 30); count > 0; --count)
+    {
+        calls.push_back(Test::randomPrimitive(random, random.range(0, POP_CLIP), -40, 170));
+    }
+    return calls;
+}
+
+template<typename Display>
+void drawFrame(Display& display, const std::vector<Test::Primitive>& calls)
+{
+    for(const Test::Primitive& call: calls)
+    {
+        if(call.kind == PUSH_VIEWPORT)
+        {
+            display.pushViewport(call.a[0] / 2, call.a[1] / 2, call.w * 2, call.h * 2);
+        }
+        else if(call.kind == POP_CLIP)
+        {
+            display.popClip();
+        }
+        else
+        {
+            Test::drawPrimitive(display, call);
+        }
+    }
+}
+
+template<int32_t HEIGHT, int32_t STRIP_PAGES>
+void checkStrips(uint32_t seed, int32_t frames)
+{
+    Test::Random random(seed);
+    random.fill(Test::primitiveBitmap, sizeof(Test::primitiveBitmap));
+    SSD1306::SimulatedSSD1306 fullPanel;
+    SSD1306::SimulatedSSD1306 stripPanel;
+    SSD1306::OledDisplay<128, HEIGHT> full(fullPanel);
+    SSD1306::StripDisplay<128, HEIGHT, STRIP_PAGES> strips(stripPanel);
+    static_assert(sizeof(strips) < sizeof(full));
+
+    for(int32_t frame = 0; frame < frames; ++frame)
+    {
+        std::vector<Test::Primitive> calls = randomFrame(random);
+        auto draw = [&](auto& display) { drawFrame(display, calls); };
+        full.clear();
+        draw(full);
+        full.resetClip();
+        full.display();
+        strips.renderStrips(draw);
+
+        bool same = true;
+        for(int32_t page = 0; page < HEIGHT / 8; ++page)
+        {
+            for(int32_t column = 0; column < 128; ++column)
+            {
+                same = same && stripPanel.ramByte(column, page) == fullPanel.ramByte(column, page);
+            }
+        }
+        if(!CHECK(same))
+        {
+            printf("  %d strip pages, frame %d\n", STRIP_PAGES, frame);
+            return;
+        }
+    }
+}
+} // namespace
+
+TEST_CASE(one_page_strips_match_the_full_buffer)
+{
+    checkStrips<64, 1>(41, 2000);
+}
+
+TEST_CASE(multi_page_strips_match_the_full_buffer)
+{
+    checkStrips<64, 2>(42, 1000);
+    checkStrips<64, 3>(43, 1000);
+    checkStrips<64, 5>(44, 1000);
+}
+
+TEST_CASE(short_panels_match_the_full_buffer)
+{
+    checkStrips<32, 1>(45, 1000);
+    checkStrips<32, 3>(46, 1000);
+}
+
+TEST_CASE(render_strips_without_strips_draws_the_full_frame)
+{
+    Test::Random random(47);
+    random.fill(Test::primitiveBitmap, sizeof(Test::primitiveBitmap));
+    SSD1306::SimulatedSSD1306 renderPanel;
+    SSD1306::SimulatedSSD1306 displayPanel;
+    SSD1306::OledDisplay<128, 64> rendered(renderPanel);
+    SSD1306::OledDisplay<128, 64> displayed(displayPanel);
+
+    for(int32_t frame = 0; frame < 100; ++frame)
+    {
+        std::vector<Test::Primitive> calls = randomFrame(random);
+        rendered.renderStrips([&](auto& display) { drawFrame(display, calls); });
+        displayed.clear();
+        drawFrame(displayed, calls);
+        displayed.resetClip();
+        displayed.display();
+        CHECK(Test::ramMatches(renderPanel, displayed));
+        CHECK(memcmp(rendered.getBuffer(), displayed.getBuffer(), rendered.FRAME_SIZE) == 0);
+    }
+}
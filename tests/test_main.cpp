@@ -0,0 +1,14 @@
+#include "test_support.hpp"
+
+int main()
+{
+    for(const Test::Case& testCase: Test::cases())
+    {
+        int32_t before = Test::failures();
+        testCase.run();
+        printf("%s %s\n", Test::failures() == before ? "PASS" : "FAIL", testCase.name);
+    }
+
+    printf("%zu cases, %d failed checks\n", Test::cases().size(), Test::failures());
+    return Test::failures() == 0 ? 0 : 1;
+}
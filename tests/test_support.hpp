@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <stddef.h>
+#include <vector>
+
+#include "ssd1306.hpp"
+#include "ssd1306_simulator.hpp"
+
+// Minimal harness for the host tests. TEST_CASE(name) defines and registers a case, CHECK()
+// reports a failed condition and carries on, and test_main.cpp runs every registered case. A
+// test binary fails when any check did.
+namespace Test
+{
+struct Case
+{
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<Case>& cases()
+{
+    static std::vector<Case> list;
+    return list;
+}
+
+inline int32_t& failures()
+{
+    static int32_t count = 0;
+    return count;
+}
+
+inline bool registerCase(const char* name, void (*run)())
+{
+    cases().push_back({name, run});
+    return true;
+}
+
+inline bool check(bool passed, const char* expression, const char* file, int line)
+{
+    if(!passed)
+    {
+        ++failures();
+        printf("%s:%d: CHECK(%s) failed\n", file, line, expression);
+    }
+    return passed;
+}
+
+inline bool checkEqual(long long actual, long long expected, const char* expression,
+                       const char* file, int line)
+{
+    if(actual != expected)
+    {
+        ++failures();
+        printf("%s:%d: CHECK_EQUAL(%s) failed: %lld != %lld\n", file, line, expression, actual,
+               expected);
+    }
+    return actual == expected;
+}
+
+// xorshift32, so randomized cases see the same sequence on every host and a failure can be
+// reproduced.
+class Random
+{
+  public:
+    explicit Random(uint32_t seed = 0x12345678) :
+        state(seed != 0 ? seed : 1)
+    {
+    }
+
+    uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Uniform in low..high, both inclusive.
+    int32_t range(int32_t low, int32_t high)
+    {
+        return low + static_cast<int32_t>(next() % static_cast<uint32_t>(high - low + 1));
+    }
+
+    uint8_t byte()
+    {
+        return static_cast<uint8_t>(next() >> 24);
+    }
+
+    void fill(uint8_t* bytes, size_t size)
+    {
+        for(size_t i = 0; i < size; ++i)
+        {
+            bytes[i] = byte();
+        }
+    }
+
+  private:
+    uint32_t state;
+};
+
+// Simulated panel that also logs the address windows it receives: the COLUMNADDR/PAGEADDR
+// command pair and the number of data bytes that followed until the next window.
+class RecordingInterface : public SSD1306::SimulatedSSD1306
+{
+  public:
+    struct Window
+    {
+        int32_t firstColumn;
+        int32_t lastColumn;
+        int32_t firstPage;
+        int32_t lastPage;
+        size_t dataBytes;
+    };
+
+    using SimulatedSSD1306::SimulatedSSD1306;
+
+    void sendCommands(uint8_t* commands, size_t size) const override
+    {
+        if(size == 6 && commands[0] == 0x21 && commands[3] == 0x22)
+        {
+            log.push_back({commands[1], commands[2], commands[4], commands[5], 0});
+        }
+        SimulatedSSD1306::sendCommands(commands, size);
+    }
+
+    void sendData(uint8_t data) const override
+    {
+        countData(1);
+        SimulatedSSD1306::sendData(data);
+    }
+
+    void sendDataBulk(uint8_t* data, size_t size) const override
+    {
+        countData(size);
+        SimulatedSSD1306::sendDataBulk(data, size);
+    }
+
+    const std::vector<Window>& windows() const
+    {
+        return log;
+    }
+
+    size_t dataBytes() const
+    {
+        size_t total = 0;
+        for(const Window& window: log)
+        {
+            total += window.dataBytes;
+        }
+        return total;
+    }
+
+    void clearLog()
+    {
+        log.clear();
+    }
+
+  private:
+    void countData(size_t size) const
+    {
+        if(!log.empty())
+        {
+            log.back().dataBytes += size;
+        }
+    }
+
+    mutable std::vector<Window> log;
+};
+
+// Frame buffer pixel, for displays with a full frame buffer.
+template<typename Display>
+bool bufferPixel(const Display& display, int32_t x, int32_t y)
+{
+    return (display.getBuffer()[(y / 8) * display.width() + x] >> (y & 7)) & 1;
+}
+
+// Replaces the whole frame buffer with frame, given in the frame buffer layout.
+template<typename Display>
+void loadFrame(Display& display, const uint8_t* frame)
+{
+    display.resetClip();
+    display.drawBitmap(0, 0, frame, display.width(), display.height(), SSD1306::DrawMode::COPY);
+}
+
+// Whether the panel RAM holds exactly the frame buffer of display.
+template<typename Display>
+bool ramMatches(const SSD1306::SimulatedSSD1306& panel, const Display& display)
+{
+    const uint8_t* buffer = display.getBuffer();
+    for(int32_t page = 0; page < display.height() / 8; ++page)
+    {
+        for(int32_t column = 0; column < display.width(); ++column)
+        {
+            if(panel.ramByte(column, page) != buffer[page * display.width() + column])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+} // namespace Test
+
+#define TEST_CASE(name)                                                                         \
+    static void name();                                                                         \
+    static const bool name##Registered = Test::registerCase(#name, name);                       \
+    static void name()
+
+#define CHECK(condition) Test::check((condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_EQUAL(actual, expected)                                                           \
+    Test::checkEqual((actual), (expected), #actual ", " #expected, __FILE__, __LINE__)
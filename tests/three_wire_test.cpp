@@ -0,0 +1,251 @@
+#include <vector>
+
+#include "ssd1306_three_wire.hpp"
+#include "test_support.hpp"
+
+// The 9-bit frames of 3-wire SPI have to carry every byte with its DC bit through the chunked
+// encoder, and decoded by the simulated panel they have to leave it as the 4-wire calls would.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+namespace ThreeWire = SSD1306::ThreeWire;
+
+namespace
+{
+// Host stand-in for ThreeWireSPIInterface: the same encoder, with each transaction's frames
+// decoded by a simulated panel instead of going out over SPI.
+template<size_t CHUNK>
+class FrameInterface : public SSD1306::HardwareInterfaceBase
+{
+  public:
+    explicit FrameInterface(SSD1306::SimulatedSSD1306& panel) :
+        panel(panel)
+    {
+    }
+
+    void initialize() override
+    {
+    }
+
+    void sendCommand(uint8_t command) const override
+    {
+        write(&command, 1, false);
+    }
+
+    void sendCommands(uint8_t* commands, size_t size) const override
+    {
+        write(commands, size, false);
+    }
+
+    void sendData(uint8_t data) const override
+    {
+        write(&data, 1, true);
+    }
+
+    void sendDataBulk(uint8_t* data, size_t size) const override
+    {
+        write(data, size, true);
+    }
+
+    void reset() const override
+    {
+        panel.reset();
+    }
+
+    void beginTransaction() const override
+    {
+        ++depth;
+    }
+
+    void endTransaction() const override
+    {
+        if(--depth == 0)
+        {
+            encoder.finish([this](const uint16_t* frames, size_t count) { flush(frames, count); });
+            panel.receiveFrames(stream.data(), stream.size());
+            stream.clear();
+        }
+    }
+
+    size_t chunks() const
+    {
+        return flushes;
+    }
+
+  private:
+    void write(const uint8_t* bytes, size_t size, bool data) const
+    {
+        beginTransaction();
+        encoder.append(bytes, size, data,
+                       [this](const uint16_t* frames, size_t count) { flush(frames, count); });
+        endTransaction();
+    }
+
+    void flush(const uint16_t* frames, size_t count) const
+    {
+        stream.insert(stream.end(), frames, frames + count);
+        ++flushes;
+    }
+
+    SSD1306::SimulatedSSD1306& panel;
+    mutable ThreeWire::FrameEncoder<CHUNK> encoder;
+    mutable std::vector<uint16_t> stream;
+    mutable int32_t depth = 0;
+    mutable size_t flushes = 0;
+};
+
+struct Flush
+{
+    const uint16_t* chunk;
+    std::vector<uint16_t> frames;
+};
+
+// Appends random runs of commands and data, with sizes around the chunk size, and checks that
+// the chunks handed over decode to the same bytes in the same order.
+template<size_t CHUNK>
+void checkChunks(uint32_t seed)
+{
+    Test::Random random(seed);
+    ThreeWire::FrameEncoder<CHUNK> encoder;
+    std::vector<uint16_t> expected;
+    std::vector<Flush> flushes;
+    auto flush = [&](const uint16_t* frames, size_t count) {
+        flushes.push_back({frames, std::vector<uint16_t>(frames, frames + count)});
+    };
+
+    for(int32_t run = 0; run < 300; ++run)
+    {
+        bool data = random.range(0, 1) == 1;
+        int32_t size = random.range(0, 1) == 1 ? random.range(0, 3) :
+                                                 static_cast<int32_t>(CHUNK) * random.range(0, 2);
+        size += random.range(-1, 1);
+        size = size < 0 ? 0 : size;
+        std::vector<uint8_t> bytes(size);
+        random.fill(bytes.data(), bytes.size());
+        encoder.append(bytes.data(), bytes.size(), data, flush);
+        for(uint8_t byte: bytes)
+        {
+            expected.push_back(ThreeWire::encode(byte, data));
+        }
+    }
+    size_t full = flushes.size();
+    encoder.finish(flush);
+    CHECK_EQUAL(flushes.size(), full + (expected.size() % CHUNK != 0 ? 1 : 0));
+
+    std::vector<uint16_t> received;
+    for(size_t i = 0; i < flushes.size(); ++i)
+    {
+        // Every chunk but the last is full, and the two chunks take turns.
+        CHECK(flushes[i].frames.size() == CHUNK || i + 1 == flushes.size());
+        CHECK(flushes[i].frames.size() > 0);
+        CHECK(i == 0 || flushes[i].chunk != flushes[i - 1].chunk);
+        CHECK(i < 2 || flushes[i].chunk == flushes[i - 2].chunk);
+        received.insert(received.end(), flushes[i].frames.begin(), flushes[i].frames.end());
+    }
+    CHECK(received == expected);
+}
+} // namespace
+
+TEST_CASE(frames_carry_the_byte_and_dc_bit)
+{
+    for(int32_t value = 0; value < 256; ++value)
+    {
+        for(bool data: {false, true})
+        {
+            uint16_t frame = ThreeWire::encode(static_cast<uint8_t>(value), data);
+            CHECK_EQUAL(ThreeWire::payload(frame), value);
+            CHECK_EQUAL(ThreeWire::isData(frame), data);
+            CHECK_EQUAL(frame >> 9, 0);
+        }
+    }
+}
+
+TEST_CASE(encoder_hands_over_full_alternating_chunks)
+{
+    checkChunks<1>(61);
+    checkChunks<7>(62);
+    checkChunks<8>(63);
+    checkChunks<128>(64);
+}
+
+TEST_CASE(received_frames_switch_between_commands_and_data)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    const uint16_t frames[] = {
+        // Horizontal addressing, then a window of columns 10 to 12 on pages 1 and 2.
+        ThreeWire::encode(0x20, false), ThreeWire::encode(0x00, false),
+        ThreeWire::encode(0x21, false), ThreeWire::encode(10, false),
+        ThreeWire::encode(12, false),   ThreeWire::encode(0x22, false),
+        ThreeWire::encode(1, false),    ThreeWire::encode(2, false),
+        ThreeWire::encode(0xA1, true),  ThreeWire::encode(0xA2, true),
+        ThreeWire::encode(0xA3, true),  ThreeWire::encode(0xA4, true),
+        // A new window within the same stream, then its data.
+        ThreeWire::encode(0x21, false), ThreeWire::encode(100, false),
+        ThreeWire::encode(100, false),  ThreeWire::encode(0x22, false),
+        ThreeWire::encode(7, false),    ThreeWire::encode(7, false),
+        ThreeWire::encode(0x5A, true),
+        // Columns 11 and 12 of page 2, next to the byte that wrapped there from page 1.
+        ThreeWire::encode(0x21, false), ThreeWire::encode(11, false),
+        ThreeWire::encode(12, false),   ThreeWire::encode(0x22, false),
+        ThreeWire::encode(2, false),    ThreeWire::encode(2, false),
+        ThreeWire::encode(0xB1, true),  ThreeWire::encode(0xB2, true),
+    };
+    panel.receiveFrames(frames, sizeof(frames) / sizeof(frames[0]));
+
+    CHECK_EQUAL(panel.ramByte(10, 1), 0xA1);
+    CHECK_EQUAL(panel.ramByte(11, 1), 0xA2);
+    CHECK_EQUAL(panel.ramByte(12, 1), 0xA3);
+    CHECK_EQUAL(panel.ramByte(10, 2), 0xA4);
+    CHECK_EQUAL(panel.ramByte(11, 2), 0xB1);
+    CHECK_EQUAL(panel.ramByte(12, 2), 0xB2);
+    CHECK_EQUAL(panel.ramByte(100, 7), 0x5A);
+    CHECK_EQUAL(panel.statistics().commandBytes, 20);
+    CHECK_EQUAL(panel.statistics().dataBytes, 7);
+    CHECK_EQUAL(panel.statistics().transactions, 1);
+    CHECK_EQUAL(panel.statistics().dcChanges, 5);
+}
+
+TEST_CASE(three_wire_stream_matches_four_wire_calls)
+{
+    SSD1306::SimulatedSSD1306 fourWirePanel;
+    SSD1306::SimulatedSSD1306 threeWirePanel;
+    FrameInterface<7> threeWire(threeWirePanel);
+    Display fourWireDisplay(fourWirePanel);
+    Display threeWireDisplay(threeWire);
+    Test::Random random(65);
+
+    for(int32_t i = 0; i < 300; ++i)
+    {
+        for(int32_t count = random.range(1, 4); count > 0; --count)
+        {
+            int32_t x = random.range(-6, 133);
+            int32_t y = random.range(-3, 66);
+            int32_t w = random.range(1, 40);
+            int32_t h = random.range(1, 20);
+            fourWireDisplay.fillRect(x, y, w, h, SSD1306::DrawMode::XOR);
+            threeWireDisplay.fillRect(x, y, w, h, SSD1306::DrawMode::XOR);
+        }
+        if(i % 17 == 0)
+        {
+            fourWireDisplay.displayFull();
+            threeWireDisplay.displayFull();
+        }
+        else
+        {
+            fourWireDisplay.display();
+            threeWireDisplay.display();
+        }
+        if(!CHECK(Test::ramMatches(threeWirePanel, fourWireDisplay)))
+        {
+            printf("  step %d\n", i);
+            return;
+        }
+    }
+
+    CHECK(threeWirePanel.isDisplayOn());
+    CHECK(threeWire.chunks() > 0);
+    const SSD1306::SimulatedSSD1306::Statistics& expected = fourWirePanel.statistics();
+    const SSD1306::SimulatedSSD1306::Statistics& actual = threeWirePanel.statistics();
+    CHECK_EQUAL(actual.commandBytes, expected.commandBytes);
+    CHECK_EQUAL(actual.dataBytes, expected.dataBytes);
+    CHECK_EQUAL(actual.dcChanges, expected.dcChanges);
+}
@@ -0,0 +1,162 @@
+#include "test_support.hpp"
+
+// display() selects the panel once for all of its windows, and within that transaction DC only
+// switches at the start of each window's commands and data, never inside a run of data.
+
+using Display = SSD1306::OledDisplay<128, 64>;
+using DiffDisplay = SSD1306::OledDisplay<128, 64, false, false, false, true>;
+using Transaction = SSD1306::SimulatedSSD1306::Transaction;
+
+namespace
+{
+// The transaction of one display() call that sent the logged windows. The first command may
+// find DC already low from the previous transfer.
+bool isOneBatch(const Test::RecordingInterface& panel)
+{
+    size_t windows = panel.windows().size();
+    if(panel.transactions().size() != 1 || windows == 0)
+    {
+        return false;
+    }
+    const Transaction& transaction = panel.transactions()[0];
+    return transaction.commandBytes == 6 * windows &&
+           transaction.dataBytes == panel.dataBytes() && transaction.dcChanges <= 2 * windows &&
+           transaction.dcChanges + 1 >= 2 * windows;
+}
+
+template<typename Target>
+void drawScattered(Target& display, Test::Random& random)
+{
+    for(int32_t count = random.range(1, 12); count > 0; --count)
+    {
+        int32_t x = random.range(-10, 130);
+        int32_t y = random.range(-10, 70);
+        switch(random.range(0, 3))
+        {
+            case 0:
+                display.drawPixel(x, y, SSD1306::DrawMode::XOR);
+                break;
+            case 1:
+                display.fillRect(x, y, random.range(1, 20), random.range(1, 20),
+                                 SSD1306::DrawMode::XOR);
+                break;
+            case 2:
+                display.drawLine(x, y, random.range(0, 127), random.range(0, 63),
+                                 SSD1306::DrawMode::XOR);
+                break;
+            default:
+                display.drawText(x, y, "42", Fonts::FontType::FONT5X8, SSD1306::DrawMode::COPY);
+                break;
+        }
+    }
+}
+} // namespace
+
+TEST_CASE(display_sends_every_window_in_one_transaction)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    Test::Random random(51);
+    display.display();
+
+    for(int32_t i = 0; i < 500; ++i)
+    {
+        drawScattered(display, random);
+        panel.clearLog();
+        panel.recordTransactions(true);
+        display.display();
+        if(panel.windows().empty())
+        {
+            // Drawing that missed the frame does not select the panel.
+            CHECK_EQUAL(panel.transactions().size(), 0);
+            continue;
+        }
+        if(!CHECK(isOneBatch(panel)) || !CHECK(Test::ramMatches(panel, display)))
+        {
+            printf("  step %d, %zu windows\n", i, panel.windows().size());
+            return;
+        }
+    }
+}
+
+TEST_CASE(diff_updates_send_every_window_in_one_transaction)
+{
+    Test::RecordingInterface panel;
+    DiffDisplay display(panel);
+    Test::Random random(52);
+    display.display();
+
+    for(int32_t i = 0; i < 500; ++i)
+    {
+        drawScattered(display, random);
+        panel.clearLog();
+        panel.resetStatistics();
+        panel.recordTransactions(true);
+        display.display();
+        if(panel.windows().empty())
+        {
+            // Drawing that changed nothing leaves an empty transaction at most.
+            CHECK(panel.transactions().size() <= 1);
+            CHECK_EQUAL(panel.statistics().dataBytes, 0);
+            continue;
+        }
+        if(!CHECK(isOneBatch(panel)) || !CHECK(Test::ramMatches(panel, display)))
+        {
+            printf("  step %d, %zu windows\n", i, panel.windows().size());
+            return;
+        }
+    }
+}
+
+TEST_CASE(full_frame_is_one_transaction)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    display.display();
+
+    panel.clearLog();
+    panel.recordTransactions(true);
+    display.displayFull();
+    CHECK(isOneBatch(panel));
+    CHECK_EQUAL(panel.transactions()[0].dataBytes, 1024);
+
+    // A few scattered changes still go out together.
+    panel.clearLog();
+    panel.recordTransactions(true);
+    display.drawChar(10, 0, 'A');
+    display.drawRect(20, 3, 10, 30);
+    display.drawPixel(127, 63);
+    display.display();
+    CHECK(isOneBatch(panel));
+    CHECK(panel.windows().size() > 1);
+}
+
+TEST_CASE(display_without_changes_does_not_select_the_panel)
+{
+    Test::RecordingInterface panel;
+    Display display(panel);
+    display.drawPixel(5, 5);
+    display.display();
+
+    panel.recordTransactions(true);
+    panel.resetStatistics();
+    display.display();
+    CHECK_EQUAL(panel.transactions().size(), 0);
+    CHECK_EQUAL(panel.statistics().transactions, 0);
+}
+
+TEST_CASE(each_strip_is_one_transaction)
+{
+    SSD1306::SimulatedSSD1306 panel;
+    SSD1306::StripDisplay<128, 64, 2> display(panel);
+
+    panel.recordTransactions(true);
+    display.renderStrips([](auto& strip) { strip.fillCircle(64, 32, 20); });
+    CHECK_EQUAL(panel.transactions().size(), 4);
+    for(const Transaction& transaction: panel.transactions())
+    {
+        CHECK_EQUAL(transaction.commandBytes, 6);
+        CHECK_EQUAL(transaction.dataBytes, 256);
+        CHECK(transaction.dcChanges <= 2);
+    }
+}
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""Converts a PBM or PNG image into a C++ header for the SSD1306 library.
+
+The image is converted into the SSD1306 page layout (one byte per column, LSB at the top) and,
+unless --raw is given, run-length encoded into the format described in
+include/compressed_bitmap.hpp, so it can be drawn with OledDisplay::drawBitmap(x, y, bitmap).
+
+PBM (P1 and P4) is read directly; other formats such as PNG need Pillow. Pixels brighter than
+the threshold (or black pixels in a PBM) are lit, --invert swaps that.
+
+    tools/bitmap_converter.py logo.png --name logo > logo.hpp
+"""
+
+import argparse
+import os
+import re
+import sys
+
+LITERAL = 0x00
+REPEAT = 0x40
+ZEROS = 0x80
+ONES = 0xC0
+MAX_RUN = 64
+
+
+def read_pbm(path):
+    with open(path, "rb") as f:
+        content = f.read()
+
+    # Header tokens may be separated by whitespace and comments.
+    tokens = []
+    position = 0
+    while len(tokens) < 3:
+        match = re.compile(rb"\s*(#[^\n]*\n\s*)*(\S+)").match(content, position)
+        if match is None:
+            raise ValueError("truncated PBM header")
+        tokens.append(match.group(2))
+        position = match.end()
+
+    magic, width, height = tokens[0], int(tokens[1]), int(tokens[2])
+    if magic == b"P1":
+        body = re.sub(rb"#[^\n]*", b"", content[position:])
+        bits = [c - ord("0") for c in body if c in b"01"]
+        pixels = [bits[y * width:(y + 1) * width] for y in range(height)]
+    elif magic == b"P4":
+        data = content[position + 1:]
+        stride = (width + 7) // 8
+        pixels = [[(data[y * stride + x // 8] >> (7 - x % 8)) & 1 for x in range(width)]
+                  for y in range(height)]
+    else:
+        raise ValueError("only P1 and P4 PBM files are supported")
+    return width, height, pixels
+
+
+def read_image(path, threshold):
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit("Pillow is required for non-PBM images (pip install Pillow)")
+
+    image = Image.open(path).convert("LA")
+    width, height = image.size
+    pixels = [[1 if (lum >= threshold and alpha >= 128) else 0
+               for lum, alpha in (image.getpixel((x, y)) for x in range(width))]
+              for y in range(height)]
+    return width, height, pixels
+
+
+def to_pages(width, height, pixels):
+    data = []
+    for page in range((height + 7) // 8):
+        for x in range(width):
+            byte = 0
+            for bit in range(8):
+                y = page * 8 + bit
+                if y < height and pixels[y][x]:
+                    byte |= 1 << bit
+            data.append(byte)
+    return data
+
+
+def compress(data):
+    out = []
+    literal = []
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:MAX_RUN]
+            del literal[:MAX_RUN]
+            out.append(LITERAL | (len(chunk) - 1))
+            out.extend(chunk)
+
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < MAX_RUN:
+            run += 1
+
+        value = data[i]
+        # Runs of 0x00 and 0xFF cost one byte, other values two, so they only pay off from 3.
+        if value in (0x00, 0xFF) and run >= 2:
+            flush_literal()
+            out.append((ZEROS if value == 0x00 else ONES) | (run - 1))
+        elif run >= 3:
+            flush_literal()
+            out.extend([REPEAT | (run - 1), value])
+        else:
+            literal.extend(data[i:i + run])
+        i += run
+
+    flush_literal()
+    return out
+
+
+def format_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("image", help="PBM or PNG (Pillow) input image")
+    parser.add_argument("--name", help="C++ identifier, defaults to the file name")
+    parser.add_argument("--raw", action="store_true",
+                        help="emit the uncompressed page layout for drawBitmap(x, y, data, w, h)")
+    parser.add_argument("--invert", action="store_true", help="swap lit and dark pixels")
+    parser.add_argument("--threshold", type=int, default=128,
+                        help="luminance at or above which a pixel is lit (non-PBM input)")
+    args = parser.parse_args()
+
+    name = args.name or re.sub(r"\W", "_", os.path.splitext(os.path.basename(args.image))[0])
+    if args.image.lower().endswith(".pbm"):
+        width, height, pixels = read_pbm(args.image)
+    else:
+        width, height, pixels = read_image(args.image, args.threshold)
+    if args.invert:
+        pixels = [[1 - p for p in row] for row in pixels]
+
+    pages = to_pages(width, height, pixels)
+    source = os.path.basename(args.image)
+
+    print("#pragma once")
+    print()
+    if args.raw:
+        print("#include <cstdint>")
+        print()
+        print("// Generated by tools/bitmap_converter.py from %s, %dx%d" % (source, width, height))
+        print("static constexpr int32_t %s_width = %d;" % (name, width))
+        print("static constexpr int32_t %s_height = %d;" % (name, height))
+        print("static constexpr uint8_t %s[] = {" % name)
+        print(format_bytes(pages))
+        print("};")
+        return
+
+    compressed = compress(pages)
+    print('#include "compressed_bitmap.hpp"')
+    print()
+    print("// Generated by tools/bitmap_converter.py from %s, %dx%d, %d -> %d bytes"
+          % (source, width, height, len(pages), len(compressed)))
+    print("static constexpr uint8_t %s_data[] = {" % name)
+    print(format_bytes(compressed))
+    print("};")
+    print("static constexpr SSD1306::CompressedBitmap %s = {%d, %d, %s_data, sizeof(%s_data)};"
+          % (name, width, height, name, name))
+
+
+if __name__ == "__main__":
+    main()